@@ -1,11 +1,24 @@
 #define SLIMFMT_CXPR_CHECKS 0
 #include <Slimfmt.hpp>
 #include <cmath>
+#include <charconv>
 #include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
+#ifdef __linux__
+# include <arpa/inet.h>
+# include <csignal>
+# include <thread>
+# include <sys/wait.h>
+# include <unistd.h>
+#endif
 
 using namespace sfmt;
 
+SLIMFMT_LOG_MODULE(driver);
+
 struct CustomType {
   const char* Str;
 };
@@ -81,6 +94,21 @@ void dbgTest(bool IsDebug) {
   Dbg("{}, {}, {}\n", 'x', 'y', 'z');
 }
 
+void dbgPrint(sfmt::Printer& Dbg) {
+  Dbg("{}, {}, {}", 'x', 'y', 'z');
+}
+
+void testLogPrinters() {
+  static sfmt::LogPrinter Net {stdout, {LogLevel::Debug, true, false, true, "[net] "}};
+  static sfmt::LogPrinter Db  {stdout, {LogLevel::Warn, false, false, true, "[db] "}};
+  Net("connected to {}:{}", "localhost", 8080);
+  Net.at(LogLevel::Trace)("dropped");
+  Db.at(LogLevel::Info)("dropped");
+  Db.at(LogLevel::Error)("query failed: {}", -1);
+  // Still works as a `Printer&`.
+  dbgPrint(Net.at(LogLevel::Warn));
+}
+
 struct Test {
   operator std::string() const {
     return "Yello";
@@ -133,6 +161,987 @@ void testTypes() {
     S, SR, SCR, SV, SVR, SVCR, T, TR, TCR);
 }
 
+/// The number of failed `expect` checks, returned from `main`.
+static int checkFailures = 0;
+
+static void expect(StrView Got, StrView Want, const char* What) {
+  if SLIMFMT_LIKELY(Got == Want)
+    return;
+  ++checkFailures;
+  sfmt::errln("FAILED {}: got \"{}\", want \"{}\"", What, Got, Want);
+}
+
+/// Checks that the format string's terminator isn't written.
+void testFormat() {
+  expect(std::to_string(sfmt::format("a").size()), "1", "format size");
+  expect(std::to_string(sfmt::format("{}", 1).size()), "1", "format size");
+}
+
+enum class Color { Red, Green, Blue };
+SLIMFMT_ENUM(Color, Red, Green, Blue)
+
+void testEnums() {
+  expect(sfmt::format("{:_>8}", Color::Green), "_______1", "padded enum");
+  expect(sfmt::format("{:_>8%n}", Color::Green), "___Green", "padded %n");
+  expect(sfmt::format("{:_<8%n}|", Color::Red), "Red_____|", "left %n");
+  expect(sfmt::format("{:_=9%n}", Color::Blue), "__Blue___", "centered %n");
+  expect(sfmt::format("{:_>4%n}", Color(7)), "___7", "unnamed %n");
+  expect(sfmt::format("{:0>4%x}", Color::Blue), "0002", "zero padded enum");
+}
+
+template <typename F>
+static double timeLoop(std::int64_t Iters, F&& Func) {
+  using TimerType = std::chrono::high_resolution_clock;
+  auto Start = TimerType::now();
+  for (std::int64_t I = 0; I < Iters; ++I)
+    Func();
+  auto End = TimerType::now();
+  return std::chrono::duration<double>(End - Start).count();
+}
+
+void benchScan() {
+  const std::string Line = sfmt::format(
+    "id={} addr={%x} len={} name={}", 123456789, 0xDEADBEEFu, 4096, "worker");
+  constexpr std::int64_t Iters = 1000000;
+  volatile unsigned Sink = 0;
+
+  double Secs = timeLoop(Iters, [&] {
+    int Id = 0, Len = 0; unsigned Addr = 0; StrView Name;
+    sfmt::scan(Line, "id={} addr={%x} len={} name={}", Id, Addr, Len, Name);
+    Sink = Sink + Id + Addr + Len + unsigned(Name.size());
+  });
+  std::cout << "sfmt::scan: " << Secs << "s for "
+    << Iters << " lines." << std::endl;
+
+  Secs = timeLoop(Iters, [&] {
+    int Id = 0, Len = 0; unsigned Addr = 0; char Name[32];
+    std::sscanf(Line.c_str(), "id=%d addr=%x len=%d name=%31s",
+      &Id, &Addr, &Len, Name);
+    Sink = Sink + Id + Addr + Len + unsigned(Name[0]);
+  });
+  std::cout << "sscanf: " << Secs << "s for "
+    << Iters << " lines." << std::endl;
+
+  Secs = timeLoop(Iters, [&] {
+    int Id = 0, Len = 0; unsigned Addr = 0;
+    const char* Ptr = Line.data() + 3;
+    const char* End = Line.data() + Line.size();
+    Ptr = std::from_chars(Ptr, End, Id).ptr + 6;
+    Ptr = std::from_chars(Ptr, End, Addr, 16).ptr + 5;
+    Ptr = std::from_chars(Ptr, End, Len).ptr + 6;
+    StrView Name(Ptr, std::size_t(End - Ptr));
+    Sink = Sink + Id + Addr + Len + unsigned(Name.size());
+  });
+  std::cout << "from_chars: " << Secs << "s for "
+    << Iters << " lines." << std::endl;
+
+  // Digit heavy fields, where the integer kernels dominate.
+  const std::string Ints = sfmt::format("{} {%x}",
+    1234567890123456ULL, 0xFEDCBA9876543210ULL);
+  Secs = timeLoop(Iters, [&] {
+    unsigned long long Dec = 0, Hex = 0;
+    sfmt::scan(Ints, "{} {%x}", Dec, Hex);
+    Sink = Sink + unsigned(Dec + Hex);
+  });
+  std::cout << "sfmt::scan (ints): " << Secs << "s for "
+    << Iters << " lines." << std::endl;
+
+  Secs = timeLoop(Iters, [&] {
+    unsigned long long Dec = 0, Hex = 0;
+    const char* End = Ints.data() + Ints.size();
+    const char* Ptr = std::from_chars(Ints.data(), End, Dec).ptr + 1;
+    std::from_chars(Ptr, End, Hex, 16);
+    Sink = Sink + unsigned(Dec + Hex);
+  });
+  std::cout << "from_chars (ints): " << Secs << "s for "
+    << Iters << " lines." << std::endl;
+}
+
+static std::string quoteJson(const std::string& Str) {
+  std::string Out;
+  for (char C : Str) {
+    if (C == '"' || C == '\\')
+      Out += '\\';
+    Out += C;
+  }
+  return Out;
+}
+
+template <typename...TT>
+static std::string logfmtStr(StrView Message, TT&&...Args) {
+  SmallBuf<128> Buf;
+  Formatter {Buf, ""}.logfmtWith(Message, {SLIMFMT_ARG(Args)...});
+  return std::string(Buf.data(), Buf.size());
+}
+
+/// Checks when logfmt values are quoted.
+void testLogfmt() {
+  expect(logfmtStr("done", "status", 200, "ok", "yes"),
+    "msg=done status=200 ok=yes", "logfmt plain");
+  expect(logfmtStr("", "k", "v"), "k=v", "logfmt no message");
+  expect(logfmtStr("two words", "path", "/a b", "eq", "a=b"),
+    "msg=\"two words\" path=\"/a b\" eq=\"a=b\"", "logfmt spaces");
+  expect(logfmtStr("", "q", "say \"hi\"", "nl", "a\nb", "tab", "\t"),
+    "q=\"say \\\"hi\\\"\" nl=\"a\\nb\" tab=\"\\t\"", "logfmt escaping");
+  expect(logfmtStr("", "e", "", "c", ' ', "n", -5),
+    "e= c=\" \" n=-5", "logfmt empty and char");
+#ifdef NDEBUG
+  // Bad keys are dropped with their value, and reported.
+  const std::uint64_t Errors = sfmt::getErrorCount();
+  expect(logfmtStr("", "a b", 1, 7, 2, "k=", 3, "ok", 4, "last"),
+    "ok=4", "logfmt bad keys");
+  expect(std::to_string(sfmt::getErrorCount() - Errors), "4",
+    "logfmt bad key errors");
+#endif
+}
+
+/// Checks the exact output of `JsonWriter`.
+void testJson() {
+  auto Str = [](const SmallBufBase& Buf) {
+    return StrView(Buf.data(), Buf.size());
+  };
+  {
+    SmallBuf<128> Buf;
+    sfmt::JsonWriter Json {Buf};
+    Json.beginObject().key("a").beginArray().endArray()
+      .key("o").beginObject().endObject()
+      .key("n").beginArray().beginArray().endArray()
+      .beginObject().endObject().endArray().endObject();
+    expect(Str(Buf), R"({"a":[],"o":{},"n":[[],{}]})", "json empty nesting");
+    expect(Json.isComplete() ? "yes" : "no", "yes", "json complete");
+  }
+  {
+    SmallBuf<128> Buf;
+    sfmt::JsonWriter Json {Buf};
+    Json.beginArray().value("q\"b\\")
+      .value(StrView("\b\f\n\r\t\x01\x1f\x7f", 8))
+      .value("k\"").endArray();
+    expect(Str(Buf),
+      "[\"q\\\"b\\\\\",\"\\b\\f\\n\\r\\t\\u0001\\u001f\x7f\",\"k\\\"\"]",
+      "json escaping");
+  }
+  {
+    SmallBuf<128> Buf;
+    sfmt::JsonWriter Json {Buf};
+    Json.beginObject().field("min", LLONG_MIN).field("max", ULLONG_MAX)
+      .field("t", true).field("z", nullptr).key("raw").rawValue("[1,2]")
+      .field("k\n", 0).endObject();
+    expect(Str(Buf), "{\"min\":-9223372036854775808,"
+      "\"max\":18446744073709551615,\"t\":true,\"z\":null,"
+      "\"raw\":[1,2],\"k\\n\":0}", "json values");
+  }
+#ifdef NDEBUG
+  // Levels past the limit are reported, and written as `null`.
+  {
+    SmallBuf<256> Buf;
+    sfmt::JsonWriter Json {Buf};
+    const std::uint64_t Errors = sfmt::getErrorCount();
+    for (int I = 0; I < 65; ++I)
+      Json.beginArray();
+    Json.value(1);
+    for (int I = 0; I < 65; ++I)
+      Json.endArray();
+    const std::string Want =
+      std::string(63, '[') + "null" + std::string(63, ']');
+    expect(Str(Buf), Want, "json too deep");
+    expect(std::to_string(sfmt::getErrorCount() - Errors), "1",
+      "json too deep errors");
+    expect(Json.isComplete() ? "yes" : "no", "yes", "json too deep complete");
+  }
+#endif
+}
+
+void benchJson() {
+  const std::string Strs[10] {
+    "GET", "/api/v1/items", "200", "example.com", "Mozilla/5.0",
+    "a \"quoted\" value", "en-US", "gzip", "keep-alive", "worker-7"
+  };
+  static const char* Keys[20] {
+    "method", "path", "status", "host", "agent",
+    "note", "lang", "encoding", "conn", "thread",
+    "id", "bytes", "latency", "port", "pid",
+    "retries", "shard", "offset", "seq", "ts"
+  };
+  constexpr std::int64_t Iters = 200000;
+  volatile std::size_t Sink = 0;
+
+  double Secs = timeLoop(Iters, [&] {
+    std::string Out = "{";
+    for (int I = 0; I < 10; ++I)
+      Out += sfmt::format("\"{}\":\"{}\",", Keys[I], quoteJson(Strs[I]));
+    for (int I = 10; I < 20; ++I)
+      Out += sfmt::format("\"{}\":{},", Keys[I], 1234567LL * I);
+    Out.back() = '}';
+    Sink = Sink + Out.size();
+  });
+  std::cout << "format + quoting: " << Secs << "s for "
+    << Iters << " records." << std::endl;
+
+  Secs = timeLoop(Iters, [&] {
+    SmallBuf<512> Buf;
+    sfmt::JsonWriter Json {Buf};
+    Json.beginObject();
+    for (int I = 0; I < 10; ++I)
+      Json.field(Keys[I], Strs[I]);
+    for (int I = 10; I < 20; ++I)
+      Json.field(Keys[I], 1234567LL * I);
+    Json.endObject();
+    Sink = Sink + Buf.size();
+  });
+  std::cout << "JsonWriter: " << Secs << "s for "
+    << Iters << " records." << std::endl;
+}
+
+/// Checks fixed point output with `%.Nq` and `%.Ng`.
+void testFixed() {
+  expect(sfmt::format("{%.2q} {%.2g}", 5, 5), "0.05 0.05", "fixed small");
+  expect(sfmt::format("{%.3q} {%.3g}", -7, -7), "-0.007 -0.007",
+    "fixed small negative");
+  expect(sfmt::format("{%.2q} {%.2g}", -150, -150), "-1.50 -1.5",
+    "fixed negative");
+  expect(sfmt::format("{%.2q} {%.2g}", 1500, 1500), "15.00 15",
+    "fixed trim all");
+  expect(sfmt::format("{%.3g} {%.2g}", -1230, 0), "-1.23 0",
+    "fixed trim some");
+  expect(sfmt::format("{%.0q} {%.0g}", -1230, 1230), "-1230 1230",
+    "fixed no digits");
+  expect(sfmt::format("{%.2q}", LLONG_MIN), "-92233720368547758.08",
+    "fixed LLONG_MIN");
+  expect(sfmt::format("{%.19q}", LLONG_MIN), "-0.9223372036854775808",
+    "fixed LLONG_MIN max precision");
+  expect(sfmt::format("{%.2q}", ULLONG_MAX), "184467440737095516.15",
+    "fixed ULLONG_MAX");
+  expect(sfmt::format("{%.19g}", ULLONG_MAX), "1.8446744073709551615",
+    "fixed ULLONG_MAX max precision");
+  expect(sfmt::format("{:0>8%.2q} {:0>8%.2q}", 5, -5), "00000.05 -0000.05",
+    "fixed zero padded");
+  expect(sfmt::format("{:0>8%.2g} {:0>8%.2g}", -150, 1200),
+    "-00001.5 00000012", "fixed trim zero padded");
+#ifdef NDEBUG
+  // Precision past 19 digits is rejected, rather than clamped.
+  // Built at runtime, so the precompiled table skips it.
+  const std::string Spec = "{%.25q}";
+  const std::uint64_t Errors = sfmt::getErrorCount();
+  SmallBuf<32> Buf;
+  Formatter {Buf, Spec}.parseWith({FmtValue(5)});
+  expect({Buf.data(), Buf.size()}, "5", "fixed precision too large");
+  expect(std::to_string(sfmt::getErrorCount() - Errors), "1",
+    "fixed precision errors");
+#endif
+}
+
+void benchFixed() {
+  constexpr std::int64_t Iters = 1000000;
+  volatile std::size_t Sink = 0;
+  long long Price = 12345678;
+
+  double Secs = timeLoop(Iters, [&] {
+    SmallBuf<64> Buf;
+    sfmt::Formatter Fmt {Buf, "{}.{:0>4}"};
+    Fmt.parseWith({Price / 10000, Price % 10000});
+    Sink = Sink + Buf.size();
+    ++Price;
+  });
+  std::cout << "{}.{:0>4}: " << Secs << "s for "
+    << Iters << " prices." << std::endl;
+
+  Secs = timeLoop(Iters, [&] {
+    char Buf[64];
+    const int Len = std::snprintf(Buf, sizeof(Buf), "%.4f", Price / 1e4);
+    Sink = Sink + std::size_t(Len);
+    ++Price;
+  });
+  std::cout << "snprintf(double): " << Secs << "s for "
+    << Iters << " prices." << std::endl;
+
+  Secs = timeLoop(Iters, [&] {
+    SmallBuf<64> Buf;
+    sfmt::Formatter Fmt {Buf, "{%.4q}"};
+    Fmt.parseWith({Price});
+    Sink = Sink + Buf.size();
+    ++Price;
+  });
+  std::cout << "{%.4q}: " << Secs << "s for "
+    << Iters << " prices." << std::endl;
+}
+
+void benchPadded() {
+  constexpr std::int64_t Iters = 1000000;
+  volatile std::size_t Sink = 0;
+  int Micros = 0;
+
+  double Secs = timeLoop(Iters, [&] {
+    SmallBuf<64> Buf;
+    sfmt::Formatter Fmt {Buf, "{:0>2}:{:0>2}:{:0>2}.{:0>6}"};
+    Fmt.parseWith({(Micros >> 12) % 24, (Micros >> 6) % 60,
+      Micros % 60, Micros});
+    Sink = Sink + Buf.size();
+    Micros = (Micros + 7919) % 1000000;
+  });
+  std::cout << "{:0>N} times: " << Secs << "s for "
+    << Iters << " stamps." << std::endl;
+
+  Secs = timeLoop(Iters, [&] {
+    char Buf[64];
+    const int Len = std::snprintf(Buf, sizeof(Buf), "%02d:%02d:%02d.%06d",
+      (Micros >> 12) % 24, (Micros >> 6) % 60, Micros % 60, Micros);
+    Sink = Sink + std::size_t(Len);
+    Micros = (Micros + 7919) % 1000000;
+  });
+  std::cout << "snprintf(%0Nd) times: " << Secs << "s for "
+    << Iters << " stamps." << std::endl;
+}
+
+void benchSpecParse() {
+  static const StrView Specs[] {
+    "", ": =*%D", ":#-*%o", "%r32p", "%x", "%X", ":0>8%x",
+    ": >12", ":*<10%c", "%.4q", ":0>2", ":_=9", "%xp", "%R36", "%u"
+  };
+  constexpr std::int64_t Iters = 1000000;
+  volatile std::size_t Sink = 0;
+  SmallBuf<16> Buf;
+  sfmt::Formatter Fmt {Buf, ""};
+
+  const double Secs = timeLoop(Iters, [&] {
+    for (const StrView& Spec : Specs) {
+      Fmt.parseReplacementSpec(Spec);
+      Sink = Sink + Fmt.getLastReplacement().Align;
+    }
+  });
+  std::cout << "parseReplacementSpec: " << Secs << "s for "
+    << (Iters * std::size(Specs)) << " specs." << std::endl;
+}
+
+/// Checks output from the precompiled table against the parser.
+/// The table is keyed by content, so a copy of the string with a
+/// trailing newline isn't found, and is parsed instead.
+static void expectPrecompiled(const std::string& Table,
+ StrView Str, FmtValue::List Values) {
+  const std::string What = "precompiled " + std::string(Str);
+  const std::string Copy = std::string(Str) + '\n';
+  expect(sfmt::findPrecompiled(Str) ? "found" : "missing", "found",
+    What.c_str());
+  expect(sfmt::findPrecompiled(Copy) ? "found" : "missing", "missing",
+    What.c_str());
+  SmallBuf<128> Buf;
+  Formatter {Buf, Copy}.parseWith(Values);
+  expect(Table + '\n', {Buf.data(), Buf.size()}, What.c_str());
+}
+
+void testPrecompiled() {
+  expectPrecompiled(sfmt::format("[{:#*}|{:.>*}]", 6, "123", 5, 42),
+    "[{:#*}|{:.>*}]",
+    {FmtValue(6), FmtValue("123"), FmtValue(5), FmtValue(42)});
+  expectPrecompiled(sfmt::format("{%.3q} {%.3g} {%.0q}", -1500, 1500, 7),
+    "{%.3q} {%.3g} {%.0q}", {FmtValue(-1500), FmtValue(1500), FmtValue(7)});
+  expectPrecompiled(sfmt::format("Trace: {%l}", "  | ", "a\nb"),
+    "Trace: {%l}", {FmtValue("  | "), FmtValue("a\nb")});
+  expectPrecompiled(sfmt::format("{%u} {%e}", "a b/c", "<a&b>"),
+    "{%u} {%e}", {FmtValue("a b/c"), FmtValue("<a&b>")});
+  expectPrecompiled(sfmt::format("{%r36} {%R36} {%b} {:0>8%X} {%O}",
+    123456789, 123456789, 10, 0xBEEF, 8),
+    "{%r36} {%R36} {%b} {:0>8%X} {%O}",
+    {FmtValue(123456789), FmtValue(123456789), FmtValue(10),
+      FmtValue(0xBEEF), FmtValue(8)});
+}
+
+void benchPrecompiled() {
+  // Only the qualified call is extracted by `slimfmt_add_precompiled`.
+  // The other string differs by one character, so it's always parsed.
+  constexpr std::int64_t Iters = 1000000;
+  volatile std::size_t Sink = 0;
+  std::uint64_t Value = 1;
+
+  double Secs = timeLoop(Iters, [&] {
+    const std::string S = format(
+      "{:0>2}:{:0>2}:{:0>2} [{}] {%x} {:>8} {%.3q}!",
+      Value % 24, Value % 60, Value % 61, "info", Value, "name", Value);
+    Sink = Sink + S.size();
+    Value = Value * 6364136223846793005ULL + 1;
+  });
+  std::cout << "parsed: " << Secs << "s for "
+    << Iters << " lines." << std::endl;
+
+  Value = 1;
+  Secs = timeLoop(Iters, [&] {
+    const std::string S = sfmt::format(
+      "{:0>2}:{:0>2}:{:0>2} [{}] {%x} {:>8} {%.3q}.",
+      Value % 24, Value % 60, Value % 61, "info", Value, "name", Value);
+    Sink = Sink + S.size();
+    Value = Value * 6364136223846793005ULL + 1;
+  });
+  std::cout << "precompiled: " << Secs << "s for "
+    << Iters << " lines." << std::endl;
+}
+
+void benchFormatBuf() {
+  constexpr std::int64_t Iters = 1000000;
+  volatile std::size_t Sink = 0;
+  std::uint64_t Value = 1;
+
+  double Secs = timeLoop(Iters, [&] {
+    const std::string S = sfmt::format(
+      "user={} id={%x} ok={}", "someone", Value, Value & 1);
+    Sink = Sink + S.size();
+    Value = Value * 6364136223846793005ULL + 1;
+  });
+  std::cout << "sfmt::format: " << Secs << "s for "
+    << Iters << " strings." << std::endl;
+
+  Value = 1;
+  Secs = timeLoop(Iters, [&] {
+    const FormatResult R = sfmt::formatBuf(
+      "user={} id={%x} ok={}", "someone", Value, Value & 1);
+    Sink = Sink + R.str().size();
+    Value = Value * 6364136223846793005ULL + 1;
+  });
+  std::cout << "sfmt::formatBuf: " << Secs << "s for "
+    << Iters << " strings." << std::endl;
+}
+
+void benchHugePages() {
+  constexpr std::int64_t Iters = 4000000;
+  SmallBuf<64> Buf;
+  std::uint64_t Value = 1;
+
+  double Secs = timeLoop(Iters, [&] {
+    sfmt::Formatter Fmt {Buf, "{%x} {}\n"};
+    Fmt.parseWith({SLIMFMT_ARG(Value), SLIMFMT_ARG(Iters)});
+    Value = Value * 6364136223846793005ULL + 1;
+  });
+  std::cout << "staging: " << Secs << "s for "
+    << Buf.size() << " bytes." << std::endl;
+
+  // Touches every page in a scattered order, like a consumer would.
+  volatile std::size_t Sink = 0;
+  Secs = timeLoop(16, [&] {
+    const std::size_t Pages = Buf.size() / 4096;
+    std::size_t Sum = 0;
+    for (std::size_t Ix = 0; Ix < Pages; ++Ix)
+      Sum += Buf.data()[((Ix * 7919) % Pages) * 4096];
+    Sink = Sink + Sum;
+  });
+  const HugePageStats Stats = sfmt::getHugePageStats();
+  std::cout << "scan: " << Secs << "s, huge pages: " 
+    << sfmt::hasHugePages(Buf.data()) << " (mapped " << Stats.Mapped
+    << ", explicit " << Stats.Explicit << ", advised " << Stats.Advised
+    << ", remapped " << Stats.Remapped << ")." << std::endl;
+}
+
+void benchDisabledLog() {
+  constexpr std::int64_t Iters = 10000000;
+  static sfmt::LogPrinter Off {stdout, {LogLevel::Off}};
+  std::string Str = "payload";
+  std::uint64_t Value = 1;
+
+  // The printer is disabled, but still boxes the arguments.
+  double Secs = timeLoop(Iters, [&] {
+    Off.at(LogLevel::Debug)("value={} str={} {%x}", Value, Str, Value);
+    Value = Value * 6364136223846793005ULL + 1;
+  });
+  std::cout << "disabled LogPrinter: " << Secs << "s for "
+    << Iters << " calls." << std::endl;
+
+  Secs = timeLoop(Iters, [&] {
+    SLIMFMT_LOG(Debug, driver, "value={} str={} {%x}", Value, Str, Value);
+    Value = Value * 6364136223846793005ULL + 1;
+  });
+  std::cout << "disabled SLIMFMT_LOG: " << Secs << "s for "
+    << Iters << " calls." << std::endl;
+  SLIMFMT_LOG(Info, driver, "last value: {%x}", Value);
+}
+
+void debugSites(int Ix) {
+  SLIMFMT_DEBUG(driver, "site one: {}", Ix);
+  SLIMFMT_DEBUG(driver, "site two: {%x}", Ix);
+}
+
+void testDebugSites() {
+  std::cout << "call sites:" << std::endl;
+  for (const CallSite& Site : sfmt::getCallSites())
+    sfmt::outln("  {}:{} [{}] \"{}\"", Site.File, Site.Line,
+      Site.Module, Site.Format);
+  debugSites(0);
+  const std::size_t Count =
+    sfmt::applyDebugControl("module driver format two +p");
+  std::cout << "enabled " << Count << " site(s)." << std::endl;
+  debugSites(1);
+
+  constexpr std::int64_t Iters = 10000000;
+  sfmt::applyDebugControl("module driver -p");
+  std::int64_t Value = 0;
+  const double Secs = timeLoop(Iters, [&] {
+    SLIMFMT_DEBUG(driver, "value={}", Value);
+    ++Value;
+  });
+  std::cout << "disabled SLIMFMT_DEBUG: " << Secs << "s for "
+    << Iters << " calls." << std::endl;
+
+#ifdef __linux__
+  const char* Path = "/tmp/slimfmt_debug_control";
+  if (std::FILE* File = std::fopen(Path, "w")) {
+    std::fputs("# Enable everything in the driver.\n", File);
+    std::fputs("module driver file Driver.cpp +p\n", File);
+    std::fclose(File);
+  }
+  if (!sfmt::watchDebugControl(Path, SIGUSR1))
+    return;
+  std::raise(SIGUSR1);
+  for (int Tries = 0; Tries < 100; ++Tries) {
+    std::size_t Enabled = 0;
+    for (const CallSite& Site : sfmt::getCallSites())
+      Enabled += Site.Enabled.load();
+    if (Enabled == sfmt::getCallSites().size())
+      break;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  debugSites(2);
+  std::remove(Path);
+  sfmt::applyDebugControl("-p");
+#endif
+}
+
+void testShmRing() {
+#ifdef __linux__
+  using TimerType = std::chrono::steady_clock;
+  constexpr int Writers = 2;
+  constexpr std::uint64_t PerWriter = 200000;
+  ShmRing Ring = ShmRing::create("slimfmt-driver", 4096, 64);
+  if (!Ring) {
+    ++checkFailures;
+    std::cout << "shm ring: FAILED to create." << std::endl;
+    return;
+  }
+
+  // Each writer is a child process, sharing the inherited mapping.
+  pid_t Pids[Writers] {};
+  for (int W = 0; W < Writers; ++W) {
+    Pids[W] = ::fork();
+    if (Pids[W] != 0)
+      continue;
+    // Lets the reader go idle first, so it needs a wakeup.
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    LogPrinter Log {&ShmRing::sink, &Ring, {LogLevel::Info}};
+    for (std::uint64_t Ix = 0; Ix < PerWriter; ++Ix)
+      Log("{} {}", W, Ix);
+    std::_Exit(0);
+  }
+
+  // Messages from a single writer must arrive in order. Writers can
+  // stall for a while on a loaded machine, so reading only stops once
+  // every message is accounted for, or the deadline passes.
+  constexpr std::uint64_t Total = Writers * PerWriter;
+  std::uint64_t Next[Writers] {};
+  std::uint64_t Received = 0, Bad = 0;
+  std::string Msg;
+  const auto Start = TimerType::now();
+  const auto Deadline = Start + std::chrono::seconds(60);
+  auto Last = Start;
+  while (Received + Bad + Ring.getStats().Dropped < Total) {
+    if (!Ring.read(Msg, 200)) {
+      if (TimerType::now() > Deadline)
+        break;
+      continue;
+    }
+    Last = TimerType::now();
+    int W = -1;
+    unsigned long long Ix = 0;
+    if (std::sscanf(Msg.c_str(), "%d %llu", &W, &Ix) != 2 ||
+     W < 0 || W >= Writers || Ix < Next[W]) {
+      ++Bad;
+      continue;
+    }
+    Next[W] = Ix + 1;
+    ++Received;
+  }
+  const std::chrono::duration<double> Secs = Last - Start;
+
+  bool ChildFailed = false;
+  for (pid_t Pid : Pids) {
+    int Status = 0;
+    if (Pid <= 0 || ::waitpid(Pid, &Status, 0) != Pid || Status != 0)
+      ChildFailed = true;
+  }
+  const ShmRing::Stats Stats = Ring.getStats();
+  const bool Ok = !ChildFailed && Bad == 0 &&
+    Received + Stats.Dropped == Total;
+  std::cout << "shm ring: " << Received << " received, " << Stats.Dropped
+    << " dropped, " << Stats.Wakeups << " wakeups in " << Secs.count()
+    << "s (" << (Ok ? "ok" : "FAILED") << ")." << std::endl;
+  if (!Ok)
+    ++checkFailures;
+#endif
+}
+
+void testToChars() {
+  char Buf[72], Ref[72];
+  std::uint64_t State = 0x2545F4914F6CDD1DULL;
+  for (int Ix = 0; Ix < 100000; ++Ix) {
+    State ^= State << 13, State ^= State >> 7, State ^= State << 17;
+    const int Base = 2 + int(State % 35);
+    const unsigned long long U = State >> (State & 63);
+    const long long S = (long long)(State >> ((State >> 8) & 63));
+
+    char* End = sfmt::toChars(Buf, Buf + sizeof(Buf), U, Base);
+    char* RefEnd = std::to_chars(Ref, Ref + sizeof(Ref), U, Base).ptr;
+    expect({Buf, std::size_t(End - Buf)},
+      {Ref, std::size_t(RefEnd - Ref)}, "toChars vs to_chars");
+    expect(std::to_string(sfmt::countDigits(U, Base)),
+      std::to_string(End - Buf), "countDigits unsigned");
+    *End = '\0';
+    if (std::strtoull(Buf, nullptr, Base) != U)
+      expect(Buf, std::to_string(U), "toChars vs strtoull");
+
+    End = sfmt::toChars(Buf, Buf + sizeof(Buf), S, Base, true);
+    expect(std::to_string(sfmt::countDigits(S, Base)),
+      std::to_string(End - Buf), "countDigits signed");
+    *End = '\0';
+    if (std::strtoll(Buf, nullptr, Base) != S)
+      expect(Buf, std::to_string(S), "toChars vs strtoll");
+  }
+
+  // Invalid bases and short buffers write nothing.
+  for (int Base : {-1, 0, 1, 37}) {
+    std::memset(Buf, '#', 4);
+    const bool Failed = !sfmt::toChars(Buf, Buf + 4, -5LL, Base) &&
+      !sfmt::toChars(Buf, Buf + 4, 5ULL, Base) &&
+      sfmt::countDigits(-5LL, Base) == -1 &&
+      sfmt::countDigits(5ULL, Base) == -1;
+    expect({Buf, 4}, Failed ? "####" : "", "toChars invalid base");
+  }
+  std::memset(Buf, '#', 4);
+  const bool Failed = !sfmt::toChars(Buf, Buf + 4, -12345LL);
+  expect({Buf, 4}, Failed ? "####" : "", "toChars short buffer");
+}
+
+/// Checks `scan` against `format`, and that failed fields assign nothing.
+void testScan() {
+  const char* Specs[] {"{}", "{%b}", "{%o}", "{%x}", "{%X}", "{%r36}"};
+  for (const char* Spec : Specs) {
+    for (long long Value : {0LL, 1LL, -1LL, 255LL, -98765LL,
+     LLONG_MAX, LLONG_MIN}) {
+      SmallBuf<80> Buf;
+      Formatter {Buf, Spec}.parseWith({Value});
+      long long Got = 0;
+      Scanner Scn {{Buf.data(), Buf.size()}, Spec};
+      const std::size_t Count = Scn.scanWith({ScanValue(Got)});
+      expect(sfmt::format("{} {}", Count, Got),
+        sfmt::format("1 {}", Value), Spec);
+    }
+    SmallBuf<80> Buf;
+    Formatter {Buf, Spec}.parseWith({ULLONG_MAX});
+    unsigned long long Got = 0;
+    Scanner Scn {{Buf.data(), Buf.size()}, Spec};
+    const std::size_t Count = Scn.scanWith({ScanValue(Got)});
+    expect(sfmt::format("{} {}", Count, Got),
+      sfmt::format("1 {}", ULLONG_MAX), Spec);
+  }
+
+  // Out of range values are rejected.
+  std::uint8_t U8 = 7;
+  std::int8_t I8 = 7;
+  unsigned long long U64 = 7;
+  std::size_t Count = sfmt::scan("300", "{}", U8);
+  expect(sfmt::format("{} {}", Count, U8), "0 7", "scan uint8 overflow");
+  Count = sfmt::scan("-129", "{}", I8);
+  expect(sfmt::format("{} {}", Count, I8), "0 7", "scan int8 overflow");
+  Count = sfmt::scan("18446744073709551616", "{}", U64);
+  expect(sfmt::format("{} {}", Count, U64), "0 7", "scan uint64 overflow");
+  Count = sfmt::scan("-1", "{}", U64);
+  expect(sfmt::format("{} {}", Count, U64), "0 7", "scan negative unsigned");
+
+  // Fixed width fields must be used entirely.
+  int Int = 0;
+  char Char = '?';
+  StrView Str = "?";
+  Count = sfmt::scan("[   42]", "[{: >6}]", Int);
+  expect(sfmt::format("{} {}", Count, Int), "0 0", "scan short int field");
+  Count = sfmt::scan("[  ab]", "[{: >4}]", Char);
+  expect(sfmt::format("{} {}", Count, Char), "0 ?", "scan short char field");
+  Count = sfmt::scan("[    42]", "[{: >6}]", Int);
+  expect(sfmt::format("{} {}", Count, Int), "1 42", "scan int field");
+  Count = sfmt::scan("|ab  |", "|{: <4}|", Str);
+  expect(sfmt::format("{} {}", Count, Str), "1 ab", "scan string field");
+
+  // A failed literal stops before the next value.
+  Int = 0;
+  Count = sfmt::scan("x=1;y=2", "x={},z={}", Int, Int);
+  expect(sfmt::format("{} {}", Count, Int), "1 1", "scan failed literal");
+}
+
+/// Checks the one-pass writer in `parseWith` against `formatValue`.
+void testSimplePath() {
+  const char* Specs[] {
+    "", "%X", ":0>8", ":0<8", ":0=9", ":_=9", ":*>10%X", ":0>12%x",
+    ": <6%b", ":#>20%o", ":0>3", ":.=7%r36", ":0>10%R36", ":->1"
+  };
+  auto Check = [](StrView Spec, FmtValue Value) {
+    const std::string Str = "{" + std::string(Spec) + "}";
+    SmallBuf<128> Simple, General;
+    Formatter {Simple, Str}.parseWith({Value});
+    Formatter Fmt {General, ""};
+    (void) Fmt.parseReplacementSpec(Spec);
+    (void) Fmt.formatValue(Value);
+    expect({Simple.data(), Simple.size()},
+      {General.data(), General.size()}, Str.c_str());
+  };
+  for (StrView Spec : Specs) {
+    Check(Spec, 0);
+    Check(Spec, -1);
+    Check(Spec, 42U);
+    Check(Spec, -12345LL);
+    Check(Spec, (long long)INT64_MIN);
+    Check(Spec, (unsigned long long)UINT64_MAX);
+    Check(Spec, 'c');
+    Check(Spec, "str");
+    Check(Spec, "");
+  }
+
+  std::uint64_t State = 0xD1B54A32D192ED03ULL;
+  for (int Ix = 0; Ix < 200000; ++Ix) {
+    State ^= State << 13, State ^= State >> 7, State ^= State << 17;
+    const StrView Spec = Specs[State % std::size(Specs)];
+    const auto Value = (long long)(State >> ((State >> 8) & 63));
+    if (State & 0x10000)
+      Check(Spec, Value);
+    else
+      Check(Spec, (unsigned long long)Value);
+  }
+}
+
+void benchToChars() {
+  constexpr std::int64_t Iters = 10000000;
+  volatile std::size_t Sink = 0;
+  std::uint64_t Value = 1;
+
+  double Secs = timeLoop(Iters, [&] {
+    char Buf[24];
+    char* End = std::to_chars(Buf, Buf + sizeof(Buf), Value).ptr;
+    Sink = Sink + std::size_t(End - Buf);
+    Value = (Value * 6364136223846793005ULL + 1) >> (Value & 63);
+  });
+  std::cout << "std::to_chars: " << Secs << "s for "
+    << Iters << " ints." << std::endl;
+
+  Value = 1;
+  Secs = timeLoop(Iters, [&] {
+    char Buf[24];
+    char* End = sfmt::toChars(Buf, Buf + sizeof(Buf), Value);
+    Sink = Sink + std::size_t(End - Buf);
+    Value = (Value * 6364136223846793005ULL + 1) >> (Value & 63);
+  });
+  std::cout << "sfmt::toChars: " << Secs << "s for "
+    << Iters << " ints." << std::endl;
+}
+
+/// Checks `bigint` against values computed separately.
+void testBigInt() {
+  const std::uint64_t Pow192[4] {0, 0, 0, 1};
+  const auto P = sfmt::bigint(Pow192, 4);
+  expect(sfmt::format("{}", P), "62771017353866807638357894232076664161"
+    "02355444464034512896", "bigint 2^192");
+  expect(sfmt::format("{%x}", P), "1" + std::string(48, '0'),
+    "bigint 2^192 hex");
+  expect(sfmt::format("{%o}", P), "1" + std::string(64, '0'),
+    "bigint 2^192 octal");
+  expect(sfmt::format("{%r32}", P), "4" + std::string(38, '0'),
+    "bigint 2^192 base 32");
+  expect(sfmt::format("{%r36}", P), "1n030ke8hj7nszs89yaz14ivfb2owprougrchs",
+    "bigint 2^192 base 36");
+
+  const std::uint64_t Max128[2] {~0ULL, ~0ULL};
+  const auto M = sfmt::bigint(Max128, 2);
+  expect(sfmt::format("{}", M), "340282366920938463463374607431768211455",
+    "bigint 2^128-1");
+  expect(sfmt::format("{%X}", M), std::string(32, 'F'),
+    "bigint 2^128-1 hex");
+  expect(sfmt::format("{%o}", M),
+    "3777777777777777777777777777777777777777777", "bigint 2^128-1 octal");
+
+  // Chunks past the first are zero filled.
+  const std::uint64_t Sparse[2] {0x098A224000000001ULL, 0x4B3B4CA85A86C47AULL};
+  expect(sfmt::format("{}", sfmt::bigint(Sparse, 2)),
+    "1" + std::string(37, '0') + "1", "bigint 10^38+1");
+
+  const std::uint64_t Mixed[4] {
+    0x0123456789ABCDEFULL, 0xFEDCBA9876543210ULL,
+    0x0F1E2D3C4B5A6978ULL, 0x00FFFFFFFFFFFFFFULL
+  };
+  const auto X = sfmt::bigint(Mixed, 4);
+  expect(sfmt::format("{%o}", X), "3777777777777777777036170551704553232"
+    "2743766713523035452062040004432126361152746757", "bigint mixed octal");
+  expect(sfmt::format("{%r32}", X),
+    "7vvvvvvvvvvs7hsb9s9dd6iu7urit9gtik688028q5cu4qnjff",
+    "bigint mixed base 32");
+
+  const std::uint64_t Zeros[3] {};
+  expect(sfmt::format("{} {%x} {%r36}", sfmt::bigint(Zeros, 3),
+    sfmt::bigint(Zeros, 3), sfmt::bigint(Zeros, 3)), "0 0 0", "bigint zero");
+  expect(sfmt::format("{} {%x}", sfmt::bigint(Zeros, 0),
+    sfmt::bigint(Zeros, 0)), "0 0", "bigint empty");
+}
+
+void benchBigInt() {
+  constexpr std::int64_t Iters = 200000;
+  volatile std::size_t Sink = 0;
+  std::uint64_t Limbs[4] {
+    0x0123456789ABCDEFULL, 0xFEDCBA9876543210ULL,
+    0x0F1E2D3C4B5A6978ULL, 0x00FFFFFFFFFFFFFFULL
+  };
+
+  double Secs = 0.0;
+#ifdef __SIZEOF_INT128__
+  Secs = timeLoop(Iters, [&] {
+    // Naive repeated division by 10.
+    std::uint64_t Work[4];
+    std::memcpy(Work, Limbs, sizeof(Work));
+    char Buf[96], *Out = Buf + sizeof(Buf);
+    bool IsZero = false;
+    while (!IsZero) {
+      std::uint64_t Rem = 0;
+      IsZero = true;
+      for (int I = 3; I >= 0; --I) {
+        const unsigned __int128 Cur = 
+          ((unsigned __int128)Rem << 64) | Work[I];
+        Work[I] = std::uint64_t(Cur / 10);
+        Rem = std::uint64_t(Cur % 10);
+        IsZero &= (Work[I] == 0);
+      }
+      *(--Out) = char('0' + Rem);
+    }
+    Sink = Sink + std::size_t(Buf + sizeof(Buf) - Out);
+    ++Limbs[0];
+  });
+  std::cout << "divide by 10: " << Secs << "s for "
+    << Iters << " 256-bit ints." << std::endl;
+#endif
+
+  Secs = timeLoop(Iters, [&] {
+    SmallBuf<128> Buf;
+    sfmt::Formatter Fmt {Buf, "{}"};
+    auto Int = sfmt::bigint(Limbs, 4);
+    Fmt.parseWith({SLIMFMT_ARG(Int)});
+    Sink = Sink + Buf.size();
+    ++Limbs[0];
+  });
+  std::cout << "sfmt::bigint: " << Secs << "s for "
+    << Iters << " 256-bit ints." << std::endl;
+}
+
+#ifdef __linux__
+static std::string ntop(int Family, const void* Addr) {
+  char Buf[INET6_ADDRSTRLEN];
+  return inet_ntop(Family, Addr, Buf, sizeof(Buf)) ? Buf : "";
+}
+#endif
+
+void testNetwork() {
+#ifdef __linux__
+  auto Check = [](const std::uint8_t(&Addr)[16]) {
+    expect(sfmt::format("{}", sfmt::ipv6(Addr)),
+      ntop(AF_INET6, Addr), "ipv6 vs inet_ntop");
+  };
+  // RFC 5952: the first of two equal runs, leading and trailing runs,
+  // single zero groups, and v4-mapped addresses.
+  const std::uint8_t Fixed[][16] {
+    {0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 1},
+    {0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0},
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1},
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    {0xfe, 0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    {0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1},
+    {0x20, 0x01, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 1},
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff, 192, 168, 0, 1},
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff, 0, 0, 0, 0},
+  };
+  for (auto& Addr : Fixed)
+    Check(Addr);
+
+  // Random groups, zero half the time to get plenty of runs.
+  std::uint64_t State = 0x9E3779B97F4A7C15ULL;
+  auto Next = [&State] {
+    State ^= State << 13, State ^= State >> 7, State ^= State << 17;
+    return State;
+  };
+  for (int Ix = 0; Ix < 200000; ++Ix) {
+    std::uint8_t Addr[16];
+    for (int G = 0; G < 8; ++G) {
+      const std::uint64_t R = Next();
+      const bool Zero = (R & 1);
+      Addr[G * 2] = Zero ? 0 : std::uint8_t(R >> 8);
+      Addr[G * 2 + 1] = Zero ? 0 : std::uint8_t(R >> 16);
+    }
+    // glibc still prints the deprecated `::a.b.c.d` form of
+    // IPv4-compatible addresses, which RFC 5952 doesn't use.
+    const std::uint8_t Zeros[12] {};
+    if (std::memcmp(Addr, Zeros, sizeof(Zeros)) != 0)
+      Check(Addr);
+    const std::uint32_t V4 = std::uint32_t(Next());
+    const std::uint32_t NetV4 = htonl(V4);
+    expect(sfmt::format("{}", sfmt::ipv4(V4)),
+      ntop(AF_INET, &NetV4), "ipv4 vs inet_ntop");
+  }
+#endif
+}
+
+void benchNetwork() {
+  constexpr std::int64_t Iters = 1000000;
+  volatile std::size_t Sink = 0;
+  std::uint8_t Addr[16] {
+    0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0,
+    0, 0, 0, 0, 0x12, 0x34, 0, 1
+  };
+
+  double Secs = timeLoop(Iters, [&] {
+    SmallBuf<64> Buf;
+    sfmt::Formatter Fmt {Buf, "{} {}"};
+    auto V4 = sfmt::ipv4(0xC0A80000 + Addr[15]);
+    auto V6 = sfmt::ipv6(Addr);
+    Fmt.parseWith({SLIMFMT_ARG(V4), SLIMFMT_ARG(V6)});
+    Sink = Sink + Buf.size();
+    ++Addr[15];
+  });
+  std::cout << "sfmt::ipv4/ipv6: " << Secs << "s for "
+    << Iters << " pairs." << std::endl;
+
+  std::uint64_t Hash[2] {0x0123456789ABCDEFULL, 0xFEDCBA9876543210ULL};
+  Secs = timeLoop(Iters, [&] {
+    SmallBuf<64> Buf;
+    sfmt::Formatter Fmt {Buf, "{:0>16%x}{:0>16%x}"};
+    Fmt.parseWith({Hash[0], Hash[1]});
+    Sink = Sink + Buf.size();
+    ++Hash[0];
+  });
+  std::cout << "{:0>16%x} x2: " << Secs << "s for "
+    << Iters << " hashes." << std::endl;
+
+  Secs = timeLoop(Iters, [&] {
+    SmallBuf<64> Buf;
+    sfmt::Formatter Fmt {Buf, "{}"};
+    auto Hex = sfmt::hexFixed(Hash, sizeof(Hash));
+    Fmt.parseWith({SLIMFMT_ARG(Hex)});
+    Sink = Sink + Buf.size();
+    ++Hash[0];
+  });
+  std::cout << "sfmt::hexFixed: " << Secs << "s for "
+    << Iters << " hashes." << std::endl;
+
+#ifdef __linux__
+  Secs = timeLoop(Iters, [&] {
+    char Buf[64];
+    const std::uint32_t V4 = htonl(0xC0A80000 + Addr[15]);
+    inet_ntop(AF_INET, &V4, Buf, sizeof(Buf));
+    std::size_t Len = std::strlen(Buf);
+    Buf[Len++] = ' ';
+    inet_ntop(AF_INET6, Addr, Buf + Len, sizeof(Buf) - Len);
+    Sink = Sink + std::strlen(Buf);
+    ++Addr[15];
+  });
+  std::cout << "inet_ntop: " << Secs << "s for "
+    << Iters << " pairs." << std::endl;
+#endif
+}
+
 int main() {
   namespace chrono = std::chrono;
   using TimerType = chrono::high_resolution_clock;
@@ -169,7 +1178,34 @@ int main() {
   
   dbgTest(true);
   dbgTest(false);
+  testLogPrinters();
 
   sfmt::null("{}", Test{});
   testTypes();
+  testFormat();
+  testEnums();
+  testNetwork();
+  testToChars();
+  testScan();
+  testJson();
+  testLogfmt();
+  testFixed();
+  testBigInt();
+  testPrecompiled();
+  testSimplePath();
+  benchScan();
+  benchJson();
+  benchFixed();
+  benchPadded();
+  benchSpecParse();
+  benchPrecompiled();
+  benchFormatBuf();
+  benchHugePages();
+  benchDisabledLog();
+  testDebugSites();
+  testShmRing();
+  benchToChars();
+  benchBigInt();
+  benchNetwork();
+  return checkFailures ? EXIT_FAILURE : EXIT_SUCCESS;
 }
@@ -17,13 +17,46 @@
 //===----------------------------------------------------------------===//
 
 #include "Slimfmt.hpp"
+#include <algorithm>
 #include <atomic>
-#include <charconv>
+#include <cerrno>
 #include <climits>
 #include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <new>
 #include <ostream>
 #include <tuple>
 
+#if defined(__unix__)
+# include <csignal>
+# include <string>
+# include <thread>
+# include <fcntl.h>
+# include <unistd.h>
+# define SLIMFMT_HAS_SIGNALS 1
+#else
+# define SLIMFMT_HAS_SIGNALS 0
+#endif
+
+#if defined(__linux__) && SLIMFMT_HUGE_PAGE_THRESHOLD > 0
+# define SLIMFMT_HUGE_PAGES 1
+# include <sys/mman.h>
+#else
+# define SLIMFMT_HUGE_PAGES 0
+#endif
+
+#if defined(__linux__)
+# include <chrono>
+# include <linux/futex.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <sys/syscall.h>
+# define SLIMFMT_HAS_SHM_RING 1
+#else
+# define SLIMFMT_HAS_SHM_RING 0
+#endif
+
 #if defined(NDEBUG) && SLIMFMT_FORCE_ASSERT
 # undef NDEBUG
 # include <cassert>
@@ -77,6 +110,20 @@ static inline int msc_clzll(std::uint64_t V) {
 
 #endif // _MSC_VER
 
+#if defined(__SSE2__) || defined(_M_X64) || \
+  (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+# include <emmintrin.h>
+# define SLIMFMT_SSE2 1
+#else
+# define SLIMFMT_SSE2 0
+#endif
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+# define SLIMFMT_LITTLE_ENDIAN 0
+#else
+# define SLIMFMT_LITTLE_ENDIAN 1
+#endif
+
 using namespace sfmt;
 using namespace sfmt::H;
 
@@ -93,6 +140,23 @@ namespace sfmt {
     return usesColor.exchange(Value);
   }
 
+  static std::atomic<std::uint64_t> errorCount {0};
+  static std::atomic<ErrorHandler> errorHandler {nullptr};
+
+  ErrorHandler setErrorHandler(ErrorHandler Handler) {
+    return errorHandler.exchange(Handler);
+  }
+  std::uint64_t getErrorCount() {
+    return errorCount.load(std::memory_order_relaxed);
+  }
+
+  /// Counts the error, and passes it to the handler if there is one.
+  static void reportError(FmtError Error, StrView Spec) {
+    errorCount.fetch_add(1, std::memory_order_relaxed);
+    if (auto* Handler = errorHandler.load(std::memory_order_relaxed))
+      Handler(Error, Spec);
+  }
+
   [[maybe_unused]] static void
    dbgprintf(const char* Function, unsigned Line, const char* Str) {
     const bool UseColors = sfmt::getColorMode();
@@ -116,7 +180,55 @@ namespace sfmt {
   static inline CLZLL_CXPR int intLog2(std::uint64_t V) {
     return 63 - clzll(V | 1);
   }
+#else
+  /// Only used where there's no faster path, like big integers.
+  static inline int intLog2(std::uint64_t V) {
+    int Log = 0;
+    while (V >>= 1)
+      ++Log;
+    return Log;
+  }
 #endif // SLIMFMT_CLZLL
+
+  static inline int popcount(std::uint32_t V) {
+#if SLIMFMT_HAS_BUILTIN(__builtin_popcount)
+    return __builtin_popcount(V);
+#else
+    V = V - ((V >> 1) & 0x55555555U);
+    V = (V & 0x33333333U) + ((V >> 2) & 0x33333333U);
+    return int((((V + (V >> 4)) & 0x0F0F0F0FU) * 0x01010101U) >> 24);
+#endif
+  }
+
+  /// Counts trailing zeros, `V` must be nonzero.
+  static inline int ctz(std::uint32_t V) {
+    assert(V != 0 && "Invalid ctz input!");
+#if SLIMFMT_HAS_BUILTIN(__builtin_ctz)
+    return __builtin_ctz(V);
+#elif defined(_MSC_VER)
+    unsigned long Out = 0;
+    _BitScanForward(&Out, V);
+    return int(Out);
+#else
+    int Out = 0;
+    while (!(V & 1U)) {
+      V >>= 1;
+      ++Out;
+    }
+    return Out;
+#endif
+  }
+
+  /// Counts trailing zeros, `V` must be nonzero.
+  static inline int ctzll(std::uint64_t V) {
+    assert(V != 0 && "Invalid ctzll input!");
+#if SLIMFMT_HAS_BUILTIN(__builtin_ctzll)
+    return __builtin_ctzll(V);
+#else
+    const auto Lo = std::uint32_t(V);
+    return Lo ? ctz(Lo) : (32 + ctz(std::uint32_t(V >> 32)));
+#endif
+  }
 } // namespace sfmt
 
 namespace {
@@ -146,10 +258,410 @@ namespace {
   MMatch(T&&) -> MMatch<std::remove_const_t<T>>;
 } // namespace `anonymous`
 
+//======================================================================//
+// Scanning
+//======================================================================//
+
+namespace {
+  /// Returns a pointer to the first `C` in `[Str, End)`, or `End`.
+  /// `memchr` is already vectorized by every libc we care about.
+  inline const char* findByte(const char* Str, const char* End, char C) {
+    if SLIMFMT_UNLIKELY(Str == End)
+      return End;
+    const void* Out = std::memchr(Str, C, std::size_t(End - Str));
+    return Out ? static_cast<const char*>(Out) : End;
+  }
+
+  /// Counts the occurences of `C` in `[Str, Str + Len)`.
+  std::size_t countByte(const char* Str, std::size_t Len, char C) {
+    std::size_t Total = 0, Ix = 0;
+#if SLIMFMT_SSE2
+    const __m128i Needle = _mm_set1_epi8(C);
+    for (; Ix + 16 <= Len; Ix += 16) {
+      const __m128i Chunk = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(Str + Ix));
+      const int Mask = _mm_movemask_epi8(_mm_cmpeq_epi8(Chunk, Needle));
+      Total += sfmt::popcount(std::uint32_t(Mask));
+    }
+#endif // SLIMFMT_SSE2
+    for (; Ix < Len; ++Ix)
+      Total += (Str[Ix] == C);
+    return Total;
+  }
+
+#if SLIMFMT_SSE2
+  inline __m128i loadChunk(const char* Str) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(Str));
+  }
+
+  inline __m128i matchByte(__m128i Chunk, char C) {
+    return _mm_cmpeq_epi8(Chunk, _mm_set1_epi8(C));
+  }
+
+  inline int maskCount(__m128i Matches) {
+    return sfmt::popcount(std::uint32_t(_mm_movemask_epi8(Matches)));
+  }
+#endif // SLIMFMT_SSE2
+
+  /// Maps each byte to the extra space needed to escape it.
+  struct EscapeTable {
+    template <typename F>
+    constexpr EscapeTable(F Func) : Extra() {
+      for (int C = 0; C < 256; ++C)
+        Extra[C] = Func(char(C));
+    }
+
+    constexpr std::size_t operator[](char C) const {
+      return Extra[static_cast<unsigned char>(C)];
+    }
+
+  public:
+    std::uint8_t Extra[256];
+  };
+
+  /// Percent-encodes everything outside the RFC 3986 unreserved set.
+  struct UrlEscaper {
+    static constexpr EscapeTable Table {[](char C) -> int {
+      const bool IsSafe =
+        (C >= 'a' && C <= 'z') || (C >= 'A' && C <= 'Z') ||
+        (C >= '0' && C <= '9') || MMatch(C).is('-', '.', '_', '~');
+      // `%XX` replaces a single character.
+      return IsSafe ? 0 : 2;
+    }};
+
+    static char* Emit(char* Out, char C) {
+      // Uppercase is recommended by the RFC.
+      constexpr const char* Digits = "0123456789ABCDEF";
+      const auto U = static_cast<unsigned char>(C);
+      Out[0] = '%';
+      Out[1] = Digits[U >> 4];
+      Out[2] = Digits[U & 0xF];
+      return Out + 3;
+    }
+
+#if SLIMFMT_SSE2
+    static __m128i Special(__m128i Chunk) {
+      // Bytes >= 0x80 are negative, so they fail both range checks.
+      const __m128i Lower = _mm_or_si128(Chunk, _mm_set1_epi8(0x20));
+      const __m128i Alpha = _mm_and_si128(
+        _mm_cmpgt_epi8(Lower, _mm_set1_epi8('a' - 1)),
+        _mm_cmplt_epi8(Lower, _mm_set1_epi8('z' + 1)));
+      const __m128i Digit = _mm_and_si128(
+        _mm_cmpgt_epi8(Chunk, _mm_set1_epi8('0' - 1)),
+        _mm_cmplt_epi8(Chunk, _mm_set1_epi8('9' + 1)));
+      const __m128i Marks = _mm_or_si128(
+        _mm_or_si128(matchByte(Chunk, '-'), matchByte(Chunk, '.')),
+        _mm_or_si128(matchByte(Chunk, '_'), matchByte(Chunk, '~')));
+      const __m128i Safe = 
+        _mm_or_si128(_mm_or_si128(Alpha, Digit), Marks);
+      return _mm_xor_si128(Safe, _mm_set1_epi8(-1));
+    }
+
+    static std::size_t ExtraSize(__m128i Chunk) {
+      return std::size_t(maskCount(Special(Chunk))) * 2;
+    }
+#endif // SLIMFMT_SSE2
+  };
+
+  /// Replaces the HTML/XML special characters with entities.
+  struct HtmlEscaper {
+    static constexpr EscapeTable Table {[](char C) -> int {
+      switch (C) {
+        case '&':  return sizeof("&amp;")  - 2;
+        case '<':  return sizeof("&lt;")   - 2;
+        case '>':  return sizeof("&gt;")   - 2;
+        case '"':  return sizeof("&quot;") - 2;
+        case '\'': return sizeof("&#39;")  - 2;
+        default:   return 0;
+      }
+    }};
+
+    static char* Emit(char* Out, char C) {
+      auto Put = [Out](StrView Entity) {
+        std::memcpy(Out, Entity.data(), Entity.size());
+        return Out + Entity.size();
+      };
+      switch (C) {
+        case '&':  return Put("&amp;");
+        case '<':  return Put("&lt;");
+        case '>':  return Put("&gt;");
+        case '"':  return Put("&quot;");
+        case '\'': return Put("&#39;");
+        default:   SLIMFMT_UNREACHABLE;
+      }
+    }
+
+#if SLIMFMT_SSE2
+    static __m128i Special(__m128i Chunk) {
+      return _mm_or_si128(
+        _mm_or_si128(matchByte(Chunk, '&'), matchByte(Chunk, '"')),
+        _mm_or_si128(
+          _mm_or_si128(matchByte(Chunk, '<'), matchByte(Chunk, '>')),
+          matchByte(Chunk, '\'')));
+    }
+
+    static std::size_t ExtraSize(__m128i Chunk) {
+      const int Amp  = maskCount(_mm_or_si128(
+        matchByte(Chunk, '&'), matchByte(Chunk, '\'')));
+      const int Tag  = maskCount(_mm_or_si128(
+        matchByte(Chunk, '<'), matchByte(Chunk, '>')));
+      const int Quot = maskCount(matchByte(Chunk, '"'));
+      return std::size_t(Amp * 4 + Tag * 3 + Quot * 5);
+    }
+#endif // SLIMFMT_SSE2
+  };
+
+  /// Gets the exact size of `Str` after escaping.
+  template <typename Esc>
+  std::size_t escapedSize(const char* Str, std::size_t Len) {
+    std::size_t Total = Len, Ix = 0;
+#if SLIMFMT_SSE2
+    for (; Ix + 16 <= Len; Ix += 16)
+      Total += Esc::ExtraSize(loadChunk(Str + Ix));
+#endif // SLIMFMT_SSE2
+    for (; Ix < Len; ++Ix)
+      Total += Esc::Table[Str[Ix]];
+    return Total;
+  }
+
+  /// Escapes `Str` into `Out`, which must fit `escapedSize(Str, Len)`.
+  /// @return The end of the written range.
+  template <typename Esc>
+  char* escapeCopy(char* Out, const char* Str, std::size_t Len) {
+    std::size_t Ix = 0;
+#if SLIMFMT_SSE2
+    for (; Ix + 16 <= Len; Ix += 16) {
+      const __m128i Chunk = loadChunk(Str + Ix);
+      auto Mask = std::uint32_t(_mm_movemask_epi8(Esc::Special(Chunk)));
+      if SLIMFMT_LIKELY(Mask == 0) {
+        // The output has at least as much space as the input left.
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(Out), Chunk);
+        Out += 16;
+        continue;
+      }
+      // Copy the runs between each special character.
+      std::size_t Pos = 0;
+      do {
+        const auto At = std::size_t(sfmt::ctz(Mask));
+        std::memcpy(Out, Str + Ix + Pos, At - Pos);
+        Out = Esc::Emit(Out + (At - Pos), Str[Ix + At]);
+        Pos = At + 1;
+        Mask &= (Mask - 1);
+      } while (Mask != 0);
+      std::memcpy(Out, Str + Ix + Pos, 16 - Pos);
+      Out += (16 - Pos);
+    }
+#endif // SLIMFMT_SSE2
+    for (; Ix < Len; ++Ix) {
+      const char C = Str[Ix];
+      if SLIMFMT_LIKELY(Esc::Table[C] == 0)
+        *Out++ = C;
+      else
+        Out = Esc::Emit(Out, C);
+    }
+    return Out;
+  }
+
+  template <typename Esc>
+  void appendEscaped(SmallBufBase& Buf, const char* Str, std::size_t Len) {
+    const std::size_t Total = escapedSize<Esc>(Str, Len);
+    if (Total == Len) {
+      Buf.append(Str, Str + Len);
+      return;
+    }
+    // Reserve the exact size once, then write in place.
+    Buf.resizeBack(Total);
+    escapeCopy<Esc>(Buf.end() - Total, Str, Len);
+  }
+
+  /// Escapes quotes, backslashes and control characters for JSON.
+  struct JsonEscaper {
+    static constexpr EscapeTable Table {[](char C) -> int {
+      switch (C) {
+        case '"':  case '\\':
+        case '\b': case '\f':
+        case '\n': case '\r':
+        case '\t': return 1;
+        default:
+          // Other control characters use `\u00XX`.
+          return (static_cast<unsigned char>(C) < 0x20) ? 5 : 0;
+      }
+    }};
+
+    static char* Emit(char* Out, char C) {
+      char Short = '\0';
+      switch (C) {
+        case '"':  Short = '"';  break;
+        case '\\': Short = '\\'; break;
+        case '\b': Short = 'b';  break;
+        case '\f': Short = 'f';  break;
+        case '\n': Short = 'n';  break;
+        case '\r': Short = 'r';  break;
+        case '\t': Short = 't';  break;
+        default: {
+          constexpr const char* Digits = "0123456789abcdef";
+          const auto U = static_cast<unsigned char>(C);
+          std::memcpy(Out, "\\u00", 4);
+          Out[4] = Digits[U >> 4];
+          Out[5] = Digits[U & 0xF];
+          return Out + 6;
+        }
+      }
+      Out[0] = '\\';
+      Out[1] = Short;
+      return Out + 2;
+    }
+
+#if SLIMFMT_SSE2
+    static __m128i Control(__m128i Chunk) {
+      // Unsigned `C <= 0x1F`.
+      const __m128i Max = _mm_set1_epi8(0x1F);
+      return _mm_cmpeq_epi8(_mm_max_epu8(Chunk, Max), Max);
+    }
+
+    static __m128i Named(__m128i Chunk) {
+      return _mm_or_si128(
+        _mm_or_si128(
+          _mm_or_si128(matchByte(Chunk, '"'), matchByte(Chunk, '\\')),
+          _mm_or_si128(matchByte(Chunk, '\b'), matchByte(Chunk, '\f'))),
+        _mm_or_si128(
+          _mm_or_si128(matchByte(Chunk, '\n'), matchByte(Chunk, '\r')),
+          matchByte(Chunk, '\t')));
+    }
+
+    static __m128i Special(__m128i Chunk) {
+      return _mm_or_si128(Control(Chunk), Named(Chunk));
+    }
+
+    static std::size_t ExtraSize(__m128i Chunk) {
+      const __m128i Short = Named(Chunk);
+      const __m128i Long  = _mm_andnot_si128(Short, Control(Chunk));
+      return std::size_t(maskCount(Short) + maskCount(Long) * 5);
+    }
+#endif // SLIMFMT_SSE2
+  };
+
+  /// Checks if a logfmt value has spaces, quotes, `=` or control characters.
+  bool needsLogfmtQuotes(const char* Str, std::size_t Len) {
+    std::size_t Ix = 0;
+#if SLIMFMT_SSE2
+    const __m128i Max = _mm_set1_epi8(0x20);
+    for (; Ix + 16 <= Len; Ix += 16) {
+      const __m128i Chunk = loadChunk(Str + Ix);
+      // Unsigned `C <= ' '`.
+      const __m128i Space = _mm_cmpeq_epi8(_mm_max_epu8(Chunk, Max), Max);
+      const __m128i Special = _mm_or_si128(Space,
+        _mm_or_si128(matchByte(Chunk, '"'), matchByte(Chunk, '=')));
+      if (_mm_movemask_epi8(Special) != 0)
+        return true;
+    }
+#endif // SLIMFMT_SSE2
+    for (; Ix < Len; ++Ix) {
+      const char C = Str[Ix];
+      if (static_cast<unsigned char>(C) <= ' ' || C == '"' || C == '=')
+        return true;
+    }
+    return false;
+  }
+
+  std::size_t escapedSize(ExtraType Extra, const char* Str, std::size_t Len) {
+    if (Extra == ExtraType::UrlEncode)
+      return escapedSize<UrlEscaper>(Str, Len);
+    return escapedSize<HtmlEscaper>(Str, Len);
+  }
+} // namespace `anonymous`
+
 //======================================================================//
 // DynBuf
 //======================================================================//
 
+namespace {
+  struct HugePageCounters {
+    std::atomic<std::uint64_t> Mapped {0};
+    std::atomic<std::uint64_t> Explicit {0};
+    std::atomic<std::uint64_t> Advised {0};
+    std::atomic<std::uint64_t> Remapped {0};
+  };
+
+  static HugePageCounters hugePageCounters {};
+
+  static void bumpCounter(std::atomic<std::uint64_t>& Counter) {
+    Counter.fetch_add(1, std::memory_order_relaxed);
+  }
+
+#if SLIMFMT_HUGE_PAGES
+  /// Mappings are rounded to the usual huge page size,
+  /// which `MAP_HUGETLB` requires.
+  constexpr std::size_t hugePageSize = std::size_t(2) << 20;
+
+  static bool isMappedSize(std::size_t Cap) {
+    return Cap >= SLIMFMT_HUGE_PAGE_THRESHOLD;
+  }
+
+  static std::size_t getMappedSize(std::size_t Cap) {
+    return (Cap + hugePageSize - 1) & ~(hugePageSize - 1);
+  }
+
+  /// Tries explicit huge pages, then advises a normal mapping.
+  static char* mapLargeBuffer(std::size_t Cap) {
+    const std::size_t Len = getMappedSize(Cap);
+    constexpr int Prot  = PROT_READ | PROT_WRITE;
+    constexpr int Flags = MAP_PRIVATE | MAP_ANONYMOUS;
+# ifdef MAP_HUGETLB
+    void* Huge = ::mmap(nullptr, Len, Prot, Flags | MAP_HUGETLB, -1, 0);
+    if (Huge != MAP_FAILED) {
+      bumpCounter(hugePageCounters.Mapped);
+      bumpCounter(hugePageCounters.Explicit);
+      return static_cast<char*>(Huge);
+    }
+# endif // MAP_HUGETLB
+    void* Ptr = ::mmap(nullptr, Len, Prot, Flags, -1, 0);
+    if SLIMFMT_UNLIKELY(Ptr == MAP_FAILED)
+      throw std::bad_alloc();
+    bumpCounter(hugePageCounters.Mapped);
+# ifdef MADV_HUGEPAGE
+    if (::madvise(Ptr, Len, MADV_HUGEPAGE) == 0)
+      bumpCounter(hugePageCounters.Advised);
+# endif // MADV_HUGEPAGE
+    return static_cast<char*>(Ptr);
+  }
+
+  /// Grows a mapping without copying.
+  /// @return `nullptr` if the mapping couldn't be moved.
+  static char* remapLargeBuffer(char* Ptr,
+   std::size_t OldCap, std::size_t NewCap) {
+# ifdef MREMAP_MAYMOVE
+    void* Out = ::mremap(Ptr, getMappedSize(OldCap),
+      getMappedSize(NewCap), MREMAP_MAYMOVE);
+    if (Out == MAP_FAILED)
+      return nullptr;
+    bumpCounter(hugePageCounters.Remapped);
+    return static_cast<char*>(Out);
+# else
+    return nullptr;
+# endif // MREMAP_MAYMOVE
+  }
+#endif // SLIMFMT_HUGE_PAGES
+} // namespace `anonymous`
+
+char* DynBuf::AllocateBuffer(size_type Cap) {
+#if SLIMFMT_HUGE_PAGES
+  if SLIMFMT_UNLIKELY(isMappedSize(Cap))
+    return mapLargeBuffer(Cap);
+#endif
+  return new char[Cap];
+}
+
+void DynBuf::DeallocateBuffer(char* Ptr, size_type Cap) {
+#if SLIMFMT_HUGE_PAGES
+  if SLIMFMT_UNLIKELY(Ptr && isMappedSize(Cap)) {
+    ::munmap(Ptr, getMappedSize(Cap));
+    return;
+  }
+#endif
+  delete[] Ptr;
+}
+
 char* DynBuf::setBufferAndCapacity(char* Ptr, size_type Cap) {
   char* OldPtr = this->Data;
   this->Data = Ptr;
@@ -175,19 +687,6 @@ void DynBuf::tweakCapacity() {
 // SmallBufImpl
 //======================================================================//
 
-SmallBufImpl::SmallBufImpl(SmallBufImpl&& Other) :
- DynBuf(static_cast<DynBuf&&>(Other)) {
-  // Immediately clear if the buffer isn't inlined.
-  if (!Other.isSelfUsingInlinedBuffer()) {
-    Other.clear();
-    return;
-  }
-  char* NewPtr = this->AllocateBuffer(this->Capacity);
-  std::memcpy(NewPtr, this->Data, this->size());
-  this->setBufferAndCapacity(NewPtr, this->Capacity);
-  Other.resetSize();
-}
-
 void SmallBufImpl::writeTo(std::basic_ostream<char>& OS) {
   if (const char* Ptr = this->data(); SLIMFMT_LIKELY(Ptr))
     OS.write(Ptr, this->size());
@@ -234,6 +733,15 @@ void SmallBufImpl::tryReserve(size_type Cap) {
   NewCapacity = std::max(NewCapacity, Cap);
   assert(NewCapacity < DynBuf::MaxSize() && "Range error!");
   char* OldPtr = this->Data;
+#if SLIMFMT_HUGE_PAGES
+  // Large buffers can be moved by the kernel instead.
+  if (OldPtr && isMappedSize(OldCapacity) && !isInlinedBuffer(OldPtr)) {
+    if (char* NewPtr = remapLargeBuffer(OldPtr, OldCapacity, NewCapacity)) {
+      this->setBufferAndCapacity(NewPtr, NewCapacity);
+      return;
+    }
+  }
+#endif
   char* NewPtr = this->AllocateBuffer(NewCapacity);
   // Suppress overflow warnings.
   H::assume(this->size() <= NewCapacity);
@@ -242,10 +750,17 @@ void SmallBufImpl::tryReserve(size_type Cap) {
     std::memcpy(NewPtr, OldPtr, this->size());
     // Free if OldPtr isn't the inlined pointer.
     if (!isInlinedBuffer(OldPtr))
-      delete[] OldPtr;
+      DynBuf::DeallocateBuffer(OldPtr, OldCapacity);
   }
 }
 
+char* BufCursor::grow(std::size_t N) {
+  this->commit();
+  Buf.reserveBack(N);
+  this->reload();
+  return this->Ptr;
+}
+
 void SmallBufImpl::move(SmallBufImpl& Other) {
   if SLIMFMT_UNLIKELY(&Other == this)
     return;
@@ -277,6 +792,7 @@ void SmallBufImpl::cloneOrTakeBuffer(SmallBufImpl& Other) {
   // Take the other buffer and clear.
   this->setBufferAndCapacity(
     Other.data(), Other.capacity());
+  this->Size = Other.size();
   Other.clearUnsafe();
 }
 
@@ -485,26 +1001,133 @@ namespace HH {
   template <std::size_t N>
   static constexpr bool isValidPow2 = (N > 1) && isPow2<N>;
 
-  /// LUT is in the range (0, 32].
+  /// LUT is in the range (0, 36].
   static constexpr std::uint64_t baseLog10LUT[] {
     0, 1, 3, 4, 6, 6, 7, 8, 9, 9,
     10, 10, 10, 11, 11, 11, 12, 12,
     12, 12, 13, 13, 13, 13, 13, 13,
-    14, 14, 14, 14, 14, 14, 15
+    14, 14, 14, 14, 14, 14, 15, 15,
+    15, 15, 15
+  };
+
+  /// Maps characters to their digit value in any base, or `0xFF`.
+  struct DigitLUT {
+    constexpr DigitLUT() : Values() {
+      for (int C = 0; C < 256; ++C) {
+        if (C >= '0' && C <= '9')
+          Values[C] = std::uint8_t(C - '0');
+        else if (C >= 'a' && C <= 'z')
+          Values[C] = std::uint8_t(C - 'a' + 10);
+        else if (C >= 'A' && C <= 'Z')
+          Values[C] = std::uint8_t(C - 'A' + 10);
+        else
+          Values[C] = 0xFF;
+      }
+    }
+
+    constexpr unsigned operator[](char C) const {
+      return Values[static_cast<unsigned char>(C)];
+    }
+
+  public:
+    std::uint8_t Values[256];
+  };
+
+  static constexpr DigitLUT digitValue {};
+
+  //=== SWAR ===//
+
+  static constexpr std::uint64_t swarOnes  = 0x0101010101010101ULL;
+  static constexpr std::uint64_t swarHigh  = 0x80 * swarOnes;
+  static constexpr std::uint64_t swarZeros = '0' * swarOnes;
+
+  /// Loads 8 characters, the first being the lowest byte.
+  inline std::uint64_t loadSwar(const char* Ptr) {
+    std::uint64_t V;
+    std::memcpy(&V, Ptr, sizeof(V));
+    return V;
+  }
+
+  /// Sets the high bit of each byte in the range `[Lo, Hi]`.
+  /// Bytes must be less than 0x80, so nothing carries.
+  constexpr std::uint64_t swarInRange(std::uint64_t V, char Lo, char Hi) {
+    const std::uint64_t Above = V + (0x80 - Lo) * swarOnes;
+    const std::uint64_t Below = V + (0x7F - Hi) * swarOnes;
+    return Above & ~Below & swarHigh;
+  }
+
+  /// Gets the number of leading characters set in `Matches`.
+  inline int swarLeading(std::uint64_t V, std::uint64_t Matches) {
+    // Non-ASCII bytes never match.
+    const std::uint64_t Rest = (~Matches | V) & swarHigh;
+    return Rest ? (sfmt::ctzll(Rest) >> 3) : 8;
+  }
+
+  /// Counts the leading decimal digits in a chunk.
+  inline int countDecSwar(std::uint64_t V) {
+    const std::uint64_t Low = V & ~swarHigh;
+    return swarLeading(V, swarInRange(Low, '0', '9'));
+  }
+
+  /// Counts the leading hex digits in a chunk.
+  inline int countHexSwar(std::uint64_t V) {
+    const std::uint64_t Low = V & ~swarHigh;
+    return swarLeading(V, swarInRange(Low, '0', '9') | 
+      swarInRange(Low | (0x20 * swarOnes), 'a', 'f'));
+  }
+
+  /// Moves the first `N` characters to the end, and fills with '0'.
+  /// This lets a partial chunk go through the same kernel.
+  constexpr std::uint64_t alignSwar(std::uint64_t V, int N) {
+    if (N == 8)
+      return V;
+    return (V << (8 * (8 - N))) | (swarZeros >> (8 * N));
+  }
+
+  /// Converts 8 decimal digits with 3 multiplies.
+  constexpr std::uint64_t parseDecSwar(std::uint64_t V) {
+    V -= swarZeros;
+    V = ((V & 0x0F0F0F0F0F0F0F0FULL) * 2561) >> 8;
+    V = ((V & 0x00FF00FF00FF00FFULL) * 6553601) >> 16;
+    return ((V & 0x0000FFFF0000FFFFULL) * 42949672960001ULL) >> 32;
+  }
+
+  /// Converts 8 hex digits by merging nibbles.
+  constexpr std::uint64_t parseHexSwar(std::uint64_t V) {
+    // Letters have bit 6 set, and their low nibble is off by 9.
+    V = (V & (0x0F * swarOnes)) + 9 * ((V >> 6) & swarOnes);
+    V = ((V << 4) | (V >> 8))  & 0x00FF00FF00FF00FFULL;
+    V = ((V << 8) | (V >> 16)) & 0x0000FFFF0000FFFFULL;
+    return std::uint32_t((V << 16) | (V >> 32));
+  }
+
+  static constexpr std::uint64_t swarPow10[] {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000
+  };
+
+  /// Every power of 10 that fits in 64 bits.
+  static constexpr std::uint64_t pow10LUT[] {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL,
+    1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL,
+    10000000000ULL, 100000000000ULL, 1000000000000ULL,
+    10000000000000ULL, 100000000000000ULL, 1000000000000000ULL,
+    10000000000000000ULL, 100000000000000000ULL,
+    1000000000000000000ULL, 10000000000000000000ULL
   };
 
-  /// LUT is in the range (0, 32].
+  /// LUT is in the range (0, 36].
   static constexpr std::uint64_t baseLog2LUT[] {
     0, 0, 1, 1, 2, 2, 2, 2, 3,
     3, 3, 3, 3, 3, 3, 3, 4,
     4, 4, 4, 4, 4, 4, 4, 4,
-    4, 4, 4, 4, 4, 4, 4, 5
+    4, 4, 4, 4, 4, 4, 4, 5,
+    5, 5, 5, 5
   };
 } // namespace HH
 
 template <std::size_t Base>
 struct BaseTraits {
-  static_assert((Base > 0) && (Base <= 32), "Base out of range!");
+  static_assert((Base > 0) && (Base <= 36), "Base out of range!");
   static constexpr bool isPow2 = HH::isPow2<Base>;
   static constexpr std::size_t pow1 = Base;
   static constexpr std::size_t pow2 = pow1 * pow1;
@@ -514,7 +1137,7 @@ struct BaseTraits {
   /// The formula for determining the digits of a number in
   /// a different base is `floor(log10(n)/log10(base)) + 1`.
   /// We can approximate this by using `~log10(x) * 10` as the inputs.
-  /// Since we only accept bases in the range [1, 32], and know the 
+  /// Since we only accept bases in the range [1, 36], and know the 
   /// maximum size in base 10, so it's easiest to just use a LUT.
   static constexpr std::size_t maxDigits = 
     (192 / HH::baseLog10LUT[Base]) + 1;
@@ -542,12 +1165,12 @@ public:
     SLIMFMT_UNREACHABLE;
   }
 
-  static inline bool Write(SmallBufBase& Buf,
+  /// Writes the digits of `V` backwards, ending at `End`.
+  /// Nothing is written when `V` is zero.
+  /// @return The first digit written.
+  static inline char* WriteBackwards(char* End,
    std::uint64_t V, bool Upper = false) {
-    // Make a buffer that fits the digits.
-    static constexpr std::size_t BufLen = BT::maxDigits;
-    char LocalBuf[BufLen + 1] {};
-    char* End = (LocalBuf + BufLen), *Out = End;
+    char* Out = End;
     const char* Digits = Upper 
       ? "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ"
       : "0123456789abcdefghijklmnopqrstuvwxyz";
@@ -560,10 +1183,41 @@ public:
         *(--Out) = Digits[Digit];
       V /= Base;
     }
+    return Out;
+  }
 
+  static inline bool Write(SmallBufBase& Buf,
+   std::uint64_t V, bool Upper = false) {
+    // Make a buffer that fits the digits.
+    static constexpr std::size_t BufLen = BT::maxDigits;
+    char LocalBuf[BufLen + 1] {};
+    char* End = (LocalBuf + BufLen);
+    char* Out = WriteBackwards(End, V, Upper);
     Buf.append(Out, End);
     return true;
   }
+
+  /// Parses digits from `[Ptr, End)` into `Out`.
+  /// @return The end of the digits, or `nullptr` on failure.
+  static inline const char* Parse(const char* Ptr,
+   const char* End, std::uint64_t& Out) {
+    constexpr std::uint64_t Limit = ~std::uint64_t(0) / Base;
+    constexpr std::uint64_t Rem   = ~std::uint64_t(0) % Base;
+    const char* const Begin = Ptr;
+    std::uint64_t V = 0;
+    for (; Ptr != End; ++Ptr) {
+      const unsigned Digit = HH::digitValue[*Ptr];
+      if (Digit >= Base)
+        break;
+      if SLIMFMT_UNLIKELY(V > Limit || (V == Limit && Digit > Rem))
+        return nullptr;
+      V = (V * Base) + Digit;
+    }
+    if SLIMFMT_UNLIKELY(Ptr == Begin)
+      return nullptr;
+    Out = V;
+    return Ptr;
+  }
 };
 
 /// @brief An integer formatting utility class.
@@ -572,7 +1226,9 @@ template <std::size_t Base, typename = void>
 class IntFormat : public GIntFormat<Base> {
 public:
   using GIntFormat<Base>::Count;
+  using GIntFormat<Base>::WriteBackwards;
   using GIntFormat<Base>::Write;
+  using GIntFormat<Base>::Parse;
 };
 
 /// @brief Explicit specialization for powers of 2, >=2.
@@ -589,11 +1245,11 @@ public:
   #endif
   }
 
-  static inline bool Write(SmallBufBase& Buf,
+  /// Writes the digits of `V` backwards, ending at `End`.
+  /// @return The first digit written.
+  static inline char* WriteBackwards(char* End,
    std::uint64_t V, [[maybe_unused]] bool Upper = false) {
-    static constexpr std::size_t BufLen = BT::maxDigits;
-    char LocalBuf[BufLen + 1] {};
-    char* End = (LocalBuf + BufLen), *Out = End;
+    char* Out = End;
     const char* Digits = Upper 
       ? "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ"
       : "0123456789abcdefghijklmnopqrstuvwxyz";
@@ -607,10 +1263,55 @@ public:
       else
         *(--Out) = Digits[Digit];
     } while((V >>= BT::shiftCount) != 0U);
+    return Out;
+  }
 
+  static inline bool Write(SmallBufBase& Buf,
+   std::uint64_t V, [[maybe_unused]] bool Upper = false) {
+    static constexpr std::size_t BufLen = BT::maxDigits;
+    char LocalBuf[BufLen + 1] {};
+    char* End = (LocalBuf + BufLen);
+    char* Out = WriteBackwards(End, V, Upper);
     Buf.append(Out, End);
     return true;
   }
+
+  static inline const char* Parse(const char* Ptr,
+   const char* End, std::uint64_t& Out) {
+    constexpr std::uint64_t Limit = 
+      (~std::uint64_t(0) >> BT::shiftCount);
+    const char* const Begin = Ptr;
+    std::uint64_t V = 0;
+  #if SLIMFMT_LITTLE_ENDIAN
+    if constexpr (Base == 16) {
+      // Take 8 digits at a time. 16 digits always fit,
+      // so the remaining digits are overflow checked below.
+      for (int I = 0; I < 2 && (End - Ptr) >= 8; ++I) {
+        const std::uint64_t Chunk = HH::loadSwar(Ptr);
+        const int N = HH::countHexSwar(Chunk);
+        if (N == 0)
+          break;
+        V = (V << (4 * N)) | HH::parseHexSwar(HH::alignSwar(Chunk, N));
+        Ptr += N;
+        if (N < 8)
+          break;
+      }
+    }
+  #endif
+    for (; Ptr != End; ++Ptr) {
+      const unsigned Digit = HH::digitValue[*Ptr];
+      if (Digit >= Base)
+        break;
+      // Check if any bits would be shifted out.
+      if SLIMFMT_UNLIKELY(V > Limit)
+        return nullptr;
+      V = (V << BT::shiftCount) | Digit;
+    }
+    if SLIMFMT_UNLIKELY(Ptr == Begin)
+      return nullptr;
+    Out = V;
+    return Ptr;
+  }
 };
 
 /// @brief Explicit specialization for base 10.
@@ -663,24 +1364,116 @@ public:
   #endif
   }
 
-  static inline bool Write(SmallBufBase& Buf,
+  /// Writes the digits of `V` backwards, ending at `End`.
+  /// @return The first digit written.
+  static inline char* WriteBackwards(char* End,
    std::uint64_t V, [[maybe_unused]] bool Upper = false) {
-    static constexpr std::size_t BufLen = BT::maxDigits;
-    char LocalBuf[BufLen + 1] {};
-    char* End = (LocalBuf + BufLen), *Out = End;
+    char* Out = End;
     // Loop in groups of 100.
     while (V >= 100)
       WriteDigitsGroup(Out, V);
     // If only one digit remains, write that and return.
     if (V < 10) {
       *(--Out) = char('0' + V);
+      return Out;
+    }
+    WriteDigitsGroup(Out, V);
+    return Out;
+  }
+
+  static inline bool Write(SmallBufBase& Buf,
+   std::uint64_t V, [[maybe_unused]] bool Upper = false) {
+    static constexpr std::size_t BufLen = BT::maxDigits;
+    char LocalBuf[BufLen + 1] {};
+    char* End = (LocalBuf + BufLen);
+    char* Out = WriteBackwards(End, V);
+    Buf.append(Out, End);
+    return true;
+  }
+
+  /// Gets the size of `V / 10^Scale` as a decimal.
+  static inline std::size_t CountFixed(
+   std::uint64_t V, std::size_t Scale, bool Trim) {
+    const std::size_t Digits = std::max<std::size_t>(Count(V), Scale + 1);
+    if (Scale == 0)
+      return Digits;
+    if (!Trim)
+      return Digits + 1;
+    std::uint64_t Frac = V % HH::pow10LUT[Scale];
+    // Drop the point with the fraction.
+    if (Frac == 0)
+      return Digits - Scale;
+    std::size_t Zeros = 0;
+    for (; (Frac % 10) == 0; Frac /= 10)
+      ++Zeros;
+    return Digits + 1 - Zeros;
+  }
+
+  /// Writes `V / 10^Scale` as a decimal, without any division by `10^Scale`.
+  /// The digits are written once, then the integer part is moved over
+  /// a single character to make room for the point.
+  static inline bool WriteFixed(SmallBufBase& Buf,
+   std::uint64_t V, std::size_t Scale, bool Trim) {
+    // Room for the digits, leading zeros and the point.
+    static constexpr std::size_t BufLen = BT::maxDigits + 2;
+    char LocalBuf[BufLen + 1] {};
+    char* End = (LocalBuf + BufLen);
+    char* Out = WriteBackwards(End, V);
+    // Pad so there's always an integer digit.
+    while (std::size_t(End - Out) <= Scale)
+      *(--Out) = '0';
+    if (Scale == 0) {
       Buf.append(Out, End);
       return true;
     }
-    WriteDigitsGroup(Out, V);
+
+    char* Point = End - Scale;
+    std::memmove(Out - 1, Out, std::size_t(Point - Out));
+    --Out;
+    Point[-1] = '.';
+    if (Trim) {
+      while (End != Point && End[-1] == '0')
+        --End;
+      if (End == Point)
+        --End;
+    }
     Buf.append(Out, End);
     return true;
   }
+
+  static inline const char* Parse(const char* Ptr,
+   const char* End, std::uint64_t& Out) {
+    constexpr std::uint64_t Limit = ~std::uint64_t(0) / 10;
+    const char* const Begin = Ptr;
+    std::uint64_t V = 0;
+  #if SLIMFMT_LITTLE_ENDIAN
+    // Take 8 digits at a time. 16 digits always fit,
+    // so the remaining digits are overflow checked below.
+    for (int I = 0; I < 2 && (End - Ptr) >= 8; ++I) {
+      const std::uint64_t Chunk = HH::loadSwar(Ptr);
+      const int N = HH::countDecSwar(Chunk);
+      if (N == 0)
+        break;
+      V = (V * HH::swarPow10[N]) + 
+        HH::parseDecSwar(HH::alignSwar(Chunk, N));
+      Ptr += N;
+      if (N < 8)
+        break;
+    }
+  #endif
+    for (; Ptr != End; ++Ptr) {
+      const auto Digit = unsigned(*Ptr) - unsigned('0');
+      if (Digit > 9)
+        break;
+      if SLIMFMT_UNLIKELY(V > Limit || (V == Limit && Digit > 5))
+        return nullptr;
+      V = (V * 10) + Digit;
+    }
+    if SLIMFMT_UNLIKELY(Ptr == Begin)
+      return nullptr;
+    Out = V;
+    return Ptr;
+  }
 };
 
 /// @brief Explicit specialization for base 1.
@@ -692,6 +1485,25 @@ public:
     return (V <= 64) ? (V | 1) : (64 + 3);
   }
 
+  /// Writes the digits of `V` backwards, ending at `End`.
+  /// @return The first digit written.
+  static inline char* WriteBackwards(char* End,
+   std::uint64_t V, [[maybe_unused]] bool Upper = false) {
+    char* Out = End;
+    if (V == 0) {
+      *(--Out) = '0';
+      return Out;
+    }
+    if (V > 64) {
+      Out -= 3;
+      std::memcpy(Out, "...", 3);
+    }
+    const auto Off = std::min<std::uint64_t>(64ULL, V);
+    Out -= Off;
+    std::memset(Out, '1', Off);
+    return Out;
+  }
+
   static inline bool Write(SmallBufBase& Buf,
    std::uint64_t V, [[maybe_unused]] bool Upper = false) {
     static constexpr char UnaryString[] =
@@ -708,8 +1520,29 @@ public:
       Buf.append("...", 3);
     return true;
   }
+
+  static inline const char* Parse(const char* Ptr,
+   const char* End, std::uint64_t& Out) {
+    if (Ptr != End && *Ptr == '0') {
+      Out = 0;
+      return Ptr + 1;
+    }
+    const char* const Begin = Ptr;
+    while (Ptr != End && *Ptr == '1')
+      ++Ptr;
+    if SLIMFMT_UNLIKELY(Ptr == Begin)
+      return nullptr;
+    Out = std::uint64_t(Ptr - Begin);
+    return Ptr;
+  }
 };
 
+/// Gets the magnitude of `V`, which is also valid for `LLONG_MIN`.
+static inline std::uint64_t absValue(long long V) {
+  const auto Out = static_cast<std::uint64_t>(V);
+  return (V < 0) ? (std::uint64_t(0) - Out) : Out;
+}
+
 } // namespace `anonymous`
 
 template <typename F>
@@ -750,6 +1583,10 @@ static inline auto baseDispatch(
    DISPATCH_BASE(30);
    DISPATCH_BASE(31);
    DISPATCH_BASE(32);
+   DISPATCH_BASE(33);
+   DISPATCH_BASE(34);
+   DISPATCH_BASE(35);
+   DISPATCH_BASE(36);
    default: {
     dbgassert(false && "Invalid base!");
     return decltype(Func(IntFormat<1>{}, Value)) {};
@@ -769,10 +1606,18 @@ static inline int countDigitsDispatch(T Value, RawBaseType Base) {
   });
 }
 
+/// Gets the size of a fixed point value, or `-1` if the spec isn't fixed.
+static inline int countFixedDigits(
+ std::uint64_t Value, const FmtReplacement& Spec) {
+  if SLIMFMT_LIKELY(!Spec.isFixed())
+    return -1;
+  const bool Trim = (Spec.Extra == ExtraType::FixedTrim);
+  return int(IntFormat<10>::CountFixed(Value, Spec.Precision, Trim));
+}
+
 int Formatter::CountDigits(long long Value, BaseSink Base) {
   const int Sign = (Value < 0LL);
-  const auto Norm = std::uint64_t(std::llabs(Value));
-  return countDigitsDispatch(Norm, Base) + Sign;
+  return countDigitsDispatch(absValue(Value), Base) + Sign;
 }
 
 int Formatter::CountDigits(unsigned long long Value, BaseSink Base) {
@@ -787,6 +1632,13 @@ std::size_t Formatter::getValueSize(FmtValue Value) const {
 
   // Get the current spec.
   auto& Spec = ParsedReplacement;
+  if SLIMFMT_UNLIKELY(Spec.isFixed() && Value.isIntType()) {
+    if (Value.isSIntType()) {
+      const long long Int = Value.getInt();
+      return countFixedDigits(absValue(Int), Spec) + (Int < 0LL);
+    }
+    return countFixedDigits(Value.getUInt(), Spec);
+  }
   if (Value.isSIntType()) {
     return CountDigits(Value.getInt(), Spec.Base);
   } else if (Value.isUIntType()) {
@@ -797,11 +1649,20 @@ std::size_t Formatter::getValueSize(FmtValue Value) const {
     // Add 2 to account for the leading 0[base].
     return countDigitsDispatch(std::uint64_t(IPtr), Spec.Base) + 2;
   } else if (Value.isCharType()) {
+    if (Spec.isEscaped()) {
+      const char C = Value.getChar();
+      return escapedSize(Spec.Extra, &C, 1);
+    }
     return 1U;
   } else if (Value.isStrType()) {
     if (Spec.Extra == ExtraType::Char)
       return 1U;
-    auto [_, Len] = Value.getStr();
+    auto [Str, Len] = Value.getStr();
+    if (Spec.hasLinePrefix() && Str)
+      // Each newline will be followed by the prefix.
+      return Len + countByte(Str, Len, '\n') * Spec.Prefix.size();
+    if (Spec.isEscaped() && Str)
+      return escapedSize(Spec.Extra, Str, Len);
     return Len;
   }
 
@@ -833,6 +1694,10 @@ bool Formatter::formatValue(FmtValue Value) const {
     return this->write(Value);
   }
   
+  // Zero padded integers are written in one pass, after the sign.
+  if (Spec.Pad == '0' && Spec.Side == AlignType::Right && Value.isIntType())
+    return this->writeZeroPadded(Value);
+
   // Handle value alignment.
   Buf.reserveBack(Spec.Align);
   const std::size_t TotalAlign = Spec.Align - Len;
@@ -854,14 +1719,102 @@ bool Formatter::formatValue(FmtValue Value) const {
   SLIMFMT_UNREACHABLE;
 }
 
-//=== Writers ===//
+bool Formatter::formatSimple(FmtValue Value, BufCursor& Cur) const {
+  auto& Spec = ParsedReplacement;
+  if (Spec.Extra != ExtraType::None && Spec.Extra != ExtraType::Uppercase)
+    return false;
+  // Unary and invalid bases are handled by the general path.
+  if (RawBaseType(Spec.Base) < 2)
+    return false;
 
-static char getRadixChar(BaseSink Base) {
-  switch (Base) {
-    case 2:  return 'b';
-    case 8:  return 'o';
-    case 10: return 'd';
-    case 16: return 'x';
+  // Matches the order in `write(FmtValue)`.
+  bool IsInt = false, IsNeg = false;
+  std::uint64_t Abs = 0;
+  const char* Str = nullptr;
+  char C = '\0';
+  std::size_t Len = 0;
+  if (Value.isSIntType()) {
+    const long long Int = Value.getInt();
+    IsInt = true;
+    IsNeg = (Int < 0);
+    Abs = absValue(Int);
+    Len = CountDigits(Int, Spec.Base);
+  } else if (Value.isUIntType()) {
+    IsInt = true;
+    Abs = Value.getUInt();
+    Len = CountDigits((unsigned long long)Abs, Spec.Base);
+  } else if (Value.isPtrType()) {
+    return false;
+  } else if (Value.isCharType()) {
+    C = Value.getChar();
+    Str = &C;
+    Len = 1;
+  } else if (Value.isStrType()) {
+    std::tie(Str, Len) = Value.getStr();
+    if SLIMFMT_UNLIKELY(!Str)
+      return false;
+  } else {
+    return false;
+  }
+
+  // Get the padding before and after the value.
+  std::size_t Before = 0, After = 0;
+  if (Spec.Align > Len) {
+    const std::size_t Fill = Spec.Align - Len;
+    if (Spec.Side == AlignType::Left)
+      After = Fill;
+    else if (Spec.Side == AlignType::Center)
+      Before = Fill / 2, After = Fill - Before;
+    else
+      Before = Fill;
+  }
+
+  char* Out = Cur.reserve(Before + Len + After);
+  Cur.advance(Before + Len + After);
+  if (!IsInt) {
+    std::memset(Out, Spec.Pad, Before);
+    std::memcpy(Out + Before, Str, Len);
+    std::memset(Out + Before + Len, Spec.Pad, After);
+    return true;
+  }
+
+  // Zero padding goes after the sign.
+  if (IsNeg) {
+    if (Spec.Pad == '0' && Spec.Side == AlignType::Right) {
+      *Out++ = '-';
+      std::memset(Out, '0', Before);
+      Out += Before;
+    } else {
+      std::memset(Out, Spec.Pad, Before);
+      Out += Before;
+      *Out++ = '-';
+    }
+  } else {
+    std::memset(Out, Spec.Pad, Before);
+    Out += Before;
+  }
+  char* const End = Out + (Len - IsNeg);
+  if (Abs == 0) {
+    *Out = '0';
+  } else {
+    const bool UseUpper = (Spec.Extra == ExtraType::Uppercase);
+    baseDispatch(Abs, Spec.Base,
+    [End, UseUpper] (auto Fmt, std::uint64_t Value) {
+      return Fmt.WriteBackwards(End, Value, UseUpper);
+    });
+  }
+  std::memset(End, Spec.Pad, After);
+  return true;
+}
+
+//=== Writers ===//
+
+static char getRadixChar(BaseSink Base) {
+  switch (Base) {
+    case 2:  return 'b';
+    case 8:  return 'o';
+    case 10: return 'd';
+    case 16: return 'x';
     default: return 'n';
   }
 }
@@ -891,11 +1844,15 @@ bool Formatter::write(FmtValue Value) const {
 }
 
 bool Formatter::write(unsigned long long Value) const {
+  auto& Spec = ParsedReplacement;
+  if SLIMFMT_UNLIKELY(Spec.isFixed()) {
+    const bool Trim = (Spec.Extra == ExtraType::FixedTrim);
+    return IntFormat<10>::WriteFixed(Buf, Value, Spec.Precision, Trim);
+  }
   if (Value == 0) {
     Buf.pushBack('0');
     return true;
   }
-  auto& Spec = ParsedReplacement;
   const bool UseUpper = 
     (Spec.Extra == ExtraType::Uppercase) &&
     (Spec.Extra != ExtraType::Ptr);
@@ -908,10 +1865,41 @@ bool Formatter::write(unsigned long long Value) const {
 bool Formatter::write(long long Value) const {
   if (Value < 0)
     Buf.pushBack('-');
-  const unsigned long long UValue = std::llabs(Value);
+  const unsigned long long UValue = absValue(Value);
   return this->write(UValue);
 }
 
+bool Formatter::writeZeroPadded(FmtValue Value) const {
+  auto& Spec = ParsedReplacement;
+  const bool IsNeg = Value.isSIntType() && (Value.getInt() < 0);
+  const std::uint64_t Abs = Value.isSIntType()
+    ? absValue(Value.getInt()) : std::uint64_t(Value.getUInt());
+  if SLIMFMT_UNLIKELY(Spec.isFixed()) {
+    // This doesn't write backwards, so just move the sign.
+    const std::size_t Len = this->getValueSize(Value);
+    if (IsNeg)
+      Buf.pushBack('-');
+    Buf.fill(Spec.Align - Len, '0');
+    return this->write((unsigned long long)Abs);
+  }
+
+  // Write the digits at the end of the field, then zero the rest.
+  Buf.resizeBack(Spec.Align);
+  char* End = Buf.end();
+  char* Begin = End - Spec.Align;
+  const bool UseUpper = (Spec.Extra == ExtraType::Uppercase);
+  char* Out = baseDispatch(Abs, Spec.Base,
+  [End, UseUpper] (auto Fmt, std::uint64_t Value) {
+    return Fmt.WriteBackwards(End, Value, UseUpper);
+  });
+  if SLIMFMT_UNLIKELY(!Out)
+    return false;
+  if (IsNeg)
+    *Begin++ = '-';
+  std::memset(Begin, '0', std::size_t(Out - Begin));
+  return true;
+}
+
 bool Formatter::write(const void* Ptr) const {
   const auto Base = ParsedReplacement.Base;
   Buf.pushBack('0');
@@ -921,6 +1909,8 @@ bool Formatter::write(const void* Ptr) const {
 }
 
 bool Formatter::write(char C) const {
+  if SLIMFMT_UNLIKELY(ParsedReplacement.isEscaped())
+    return this->write(FmtValue::StrAndLen{&C, 1});
   Buf.pushBack(C);
   return true;
 }
@@ -930,10 +1920,42 @@ bool Formatter::write(FmtValue::StrAndLen FatStr) const {
   if SLIMFMT_UNLIKELY(!Str)
     return false;
   // TODO: Check for ExtraType::Char here?
+  if (ParsedReplacement.hasLinePrefix())
+    return this->writeLinePrefixed(Str, Len);
+  if (ParsedReplacement.Extra == ExtraType::UrlEncode) {
+    appendEscaped<UrlEscaper>(Buf, Str, Len);
+    return true;
+  } else if (ParsedReplacement.Extra == ExtraType::HtmlEscape) {
+    appendEscaped<HtmlEscaper>(Buf, Str, Len);
+    return true;
+  }
   Buf.append(Str, Str + Len);
   return true;
 }
 
+bool Formatter::writeLinePrefixed(const char* Str, std::size_t Len) const {
+  const StrView Prefix = ParsedReplacement.Prefix;
+  const char* End = Str + Len;
+  const char* Line = findByte(Str, End, '\n');
+  // Most arguments are a single line, so copy those directly.
+  if SLIMFMT_LIKELY(Line == End || Prefix.empty()) {
+    Buf.append(Str, End);
+    return true;
+  }
+
+  do {
+    // Include the newline, then insert the prefix.
+    ++Line;
+    Buf.append(Str, Line);
+    Buf.appendStr(Prefix);
+    Str  = Line;
+    Line = findByte(Str, End, '\n');
+  } while (Line != End);
+
+  Buf.append(Str, End);
+  return true;
+}
+
 bool Formatter::write(const AnyFmt& Generic) const {
   Generic.doFormat(*this);
   return true;
@@ -944,218 +1966,359 @@ bool Formatter::write(const SmallBufBase& InBuf) const {
   return true;
 }
 
-//=== Spec Parsing ===//
-
-std::size_t doFromChars(const char* Data, std::size_t DigitCount) {
-  const char* End = Data + DigitCount;
-  std::size_t Output;
-  auto [Ptr, EC] = std::from_chars(Data, End, Output);
+//=== Enums ===//
 
-  // Check the error code.
-  if SLIMFMT_UNLIKELY(EC != std::errc{}) {
-    auto Err = std::make_error_code(EC).message();
-    std::fprintf(stderr, "\"%s\" at %c.\n", Err.c_str(), *Ptr);
-    dbgassert(false && "Invalid width specifier!");
-    return 0;
+StrView EnumTable::find(std::uint64_t Value) const {
+  if SLIMFMT_LIKELY(this->IsDense) {
+    const std::uint64_t Idx = Value - Values[0];
+    return (Idx < Count) ? getName(std::size_t(Idx)) : StrView();
   }
-
-  return Output;
-}
-
-void Formatter::setReplacementSubstr(std::size_t Len) {
-  if (Len == StrView::npos)
-    Len = FormatString.size();
-  this->ParsedReplacement = 
-    FmtReplacement(FormatString.substr(0, Len));
+  for (std::size_t Idx = 0; Idx < Count; ++Idx) {
+    if (Values[Idx] == Value)
+      return getName(Idx);
+  }
+  return StrView();
 }
 
-void Formatter::setReplacementSubstr(std::size_t Pos, std::size_t Len) {
-  this->ParsedReplacement = 
-    FmtReplacement(FormatString.substr(Pos, Len));
-}
+namespace {
+  /// Appends the name of `Value`, or each of its flags.
+  /// @return `false` if a plain enum value has no name.
+  bool appendEnumName(SmallBufBase& Buf,
+   std::uint64_t Value, const EnumTable& Table) {
+    if (!Table.IsFlags || Value == 0) {
+      const StrView Name = Table.find(Value);
+      if SLIMFMT_UNLIKELY(Name.empty())
+        return false;
+      Buf.appendStr(Name);
+      return true;
+    }
 
-StrView Formatter::collectBraces() const {
-  const auto BraceEnd = FormatString.find_first_not_of('{');
-  if SLIMFMT_UNLIKELY(BraceEnd == StrView::npos)
-    return StrView();
-  return FormatString.substr(0, BraceEnd);
-}
+    // Print each set bit by name, joined with '|'.
+    std::uint64_t Unnamed = 0;
+    bool IsFirst = true;
+    for (std::uint64_t Bits = Value; Bits != 0; Bits &= (Bits - 1)) {
+      const int Bit = sfmt::ctzll(Bits);
+      const std::uint8_t Idx = Table.BitIndex[Bit];
+      if SLIMFMT_UNLIKELY(Idx == 0xFF) {
+        Unnamed |= (std::uint64_t(1) << Bit);
+        continue;
+      }
+      if (!IsFirst)
+        Buf.pushBack('|');
+      Buf.appendStr(Table.getName(Idx));
+      IsFirst = false;
+    }
 
-static AlignType parseRSpecSide(StrView& Spec) {
-  if SLIMFMT_UNLIKELY(Spec.empty())
-    return AlignType::Default;
-  const char AlignChar = Spec.front();
-  // If the character is in the range [0-9].
-  if SLIMFMT_UNLIKELY(std::isdigit(AlignChar))
-    return AlignType::Default;
-  Spec.remove_prefix(1);
-  switch (AlignChar) {
-    // Next
-    case '%':
-    // Left
-    case '+':
-    case '<': return AlignType::Left;
-    // Center
-    case '=':
-    case ' ': return AlignType::Center;
-    // Right
-    case '-':
-    case '>': return AlignType::Right;
-    default: {
-      dbgassert(false && "Invalid alignment specifier!");
-      return AlignType::Default;
+    // Print any leftover bits in hex.
+    if SLIMFMT_UNLIKELY(Unnamed != 0) {
+      if (!IsFirst)
+        Buf.pushBack('|');
+      Buf.append("0x", 2);
+      IntFormat<16>::Write(Buf, Unnamed);
     }
+    return true;
   }
-  SLIMFMT_UNREACHABLE;
-}
+} // namespace `anonymous`
 
-static std::size_t parseRSpecAlign(StrView& Spec) {
-  if SLIMFMT_UNLIKELY(Spec.empty())
-    return 0;
-  // Dynamic align character
-  if (Spec.front() == '*') {
-    Spec.remove_prefix(1);
-    return FmtReplacement::dynamicAlign;
-  }
+bool Formatter::writeEnum(std::uint64_t Value, const EnumTable& Table) const {
+  auto& Spec = ParsedReplacement;
+  // Values are formatted (and aligned) like any other integer.
+  auto WriteInt = [&, this] {
+    if (Table.IsSigned)
+      return this->formatValue(static_cast<long long>(Value));
+    return this->formatValue(static_cast<unsigned long long>(Value));
+  };
+  if (Spec.Extra != ExtraType::Name)
+    return WriteInt();
 
-  // Look for the next sections spec identifier.
-  // If it doesn't exist, just use the whole string.
-  std::size_t DigitCount = Spec.find_first_of('%');
-  DigitCount = std::min(DigitCount, Spec.size());
-  const char* Data = Spec.data();
-  Spec.remove_prefix(DigitCount);
-  return doFromChars(Data, DigitCount);
+  const std::size_t Start = Buf.size();
+  if SLIMFMT_UNLIKELY(!appendEnumName(Buf, Value, Table))
+    // Fall back to the integer value.
+    return WriteInt();
+
+  // Flags can't be measured up front, so align after writing.
+  const std::size_t Len = Buf.size() - Start;
+  if (Spec.Align <= Len)
+    return true;
+  const std::size_t Fill = Spec.Align - Len;
+  std::size_t Before = Fill;
+  if (Spec.Side == AlignType::Left)
+    Before = 0;
+  else if (Spec.Side == AlignType::Center)
+    Before = Fill / 2;
+  Buf.resizeBack(Fill);
+  char* const Name = Buf.begin() + Start;
+  std::memmove(Name + Before, Name, Len);
+  std::memset(Name, Spec.Pad, Before);
+  std::memset(Name + Before + Len, Spec.Pad, Fill - Before);
+  return true;
 }
 
-// TODO: Handle arbitrary radix formatting, %r[VALUE]
-static std::pair<BaseSink, ExtraType> 
- parseRSpecOptions(StrView S) {
-  if (S.empty())
-    return {BaseType::Default, ExtraType::Default};
+//=== Spec Parsing ===//
 
-  BaseSink Base = BaseType::Default;
-  ExtraType Extra = ExtraType::Default;
+namespace {
+  /// The classes of characters in a replacement spec.
+  enum class SpecClass : std::uint8_t {
+    Invalid, Digit, Star, Percent, Dot,
+    Side, Base, Radix, Extra
+  };
 
-  // Recurse to find the back, then continue.
-  if (S.size() > 1 && std::isalpha(S.back())) {
-    // We start from the back to support things like %op.
-    // Starting from the front would require more checks.
-    std::tie(Base, Extra) = 
-      parseRSpecOptions({&S.back(), 1});
-    S.remove_suffix(1);
-  }
-
-  // Determine the Option type.
-  switch (S[0]) {
-    // Arbitrary Radix:
-    case 'R':
-      Extra = ExtraType::Uppercase;
-    case 'r': {
-      // Remove leading character.
-      S.remove_prefix(1);
-      Base = doFromChars(S.data(), S.size());
-      dbgassert(Base <= 32 && "Base out of range!");
-      break;
-    }
+  struct SpecChar {
+    SpecClass Class = SpecClass::Invalid;
+    /// The side, base, or extra type, depending on the class.
+    std::uint8_t Value = 0;
+    bool Upper = false;
+  };
 
-    // Bases:
-    case 'B':
-    case 'b': {
-      Base = BaseType::Bin;
-      break;
-    }
-    case 'O':
-    case 'o': {
-      Base = BaseType::Oct;
-      break;
-    }
-    case 'D':
-    case 'd': {
-      Base = BaseType::Dec;
-      break;
+  /// Classifies every character, so the spec can be parsed
+  /// in a single pass without any library calls.
+  struct SpecLUT {
+    constexpr SpecLUT() {
+      for (int C = '0'; C <= '9'; ++C)
+        set(C, SpecClass::Digit);
+      set('*', SpecClass::Star);
+      set('%', SpecClass::Percent);
+      set('.', SpecClass::Dot);
+      // Sides
+      set('+', SpecClass::Side, std::uint8_t(AlignType::Left));
+      set('<', SpecClass::Side, std::uint8_t(AlignType::Left));
+      set('=', SpecClass::Side, std::uint8_t(AlignType::Center));
+      set(' ', SpecClass::Side, std::uint8_t(AlignType::Center));
+      set('-', SpecClass::Side, std::uint8_t(AlignType::Right));
+      set('>', SpecClass::Side, std::uint8_t(AlignType::Right));
+      // Bases
+      setCased('b', SpecClass::Base, 2);
+      setCased('o', SpecClass::Base, 8);
+      setCased('d', SpecClass::Base, 10);
+      setCased('x', SpecClass::Base, 16);
+      setCased('h', SpecClass::Base, 16);
+      setCased('r', SpecClass::Radix, 0);
+      // Extras
+      setCased('p', SpecClass::Extra, std::uint8_t(ExtraType::Ptr));
+      setCased('c', SpecClass::Extra, std::uint8_t(ExtraType::Char));
+      set('l', SpecClass::Extra, std::uint8_t(ExtraType::LinePrefix));
+      set('u', SpecClass::Extra, std::uint8_t(ExtraType::UrlEncode));
+      set('e', SpecClass::Extra, std::uint8_t(ExtraType::HtmlEscape));
+      set('n', SpecClass::Extra, std::uint8_t(ExtraType::Name));
+      set('q', SpecClass::Extra, std::uint8_t(ExtraType::Fixed));
+      set('g', SpecClass::Extra, std::uint8_t(ExtraType::FixedTrim));
     }
-    case 'H':
-    case 'X':
-      Extra = ExtraType::Uppercase;
-    case 'x':
-    case 'h': {
-      Base = BaseType::Hex;
-      break;
+
+    constexpr const SpecChar& operator[](char C) const {
+      return Chars[static_cast<unsigned char>(C)];
     }
 
-    // Extra:
-    case 'P':
-    case 'p': {
-      dbgassert(Extra == ExtraType::None && 
-        "Type specifier will be overwritten!");
-      Base = BaseType::Hex;
-      // Pointers always print lowercase.
-      Extra = ExtraType::Ptr;
-      break;
+  private:
+    constexpr void set(int C, SpecClass Class, 
+     std::uint8_t Value = 0, bool Upper = false) {
+      Chars[C].Class = Class;
+      Chars[C].Value = Value;
+      Chars[C].Upper = Upper;
     }
-    case 'C':
-    case 'c': {
-      dbgassert(Extra == ExtraType::None && 
-        "Type specifier will be overwritten!");
-      Extra = ExtraType::Char;
-      break;
+    constexpr void setCased(char C, SpecClass Class, std::uint8_t Value) {
+      set(C, Class, Value);
+      set(C - 'a' + 'A', Class, Value, true);
     }
-    default:
-      dbgassert(false && "Invalid spec option!");
-      std::fprintf(stderr, ": %c\n", S[0]);
+
+  public:
+    SpecChar Chars[256] {};
+  };
+
+  static constexpr SpecLUT specLUT {};
+
+  /// Parses decimal digits from `[Ptr, End)` into `Out`.
+  /// @return The end of the digits, or `nullptr` on failure.
+  const char* parseSpecInt(const char* Ptr,
+   const char* End, std::size_t& Out) {
+    std::uint64_t Value = 0;
+    Ptr = IntFormat<10>::Parse(Ptr, End, Value);
+    if SLIMFMT_UNLIKELY(!Ptr)
+      return nullptr;
+    Out = std::size_t(Value);
+    return Ptr;
   }
+} // namespace `anonymous`
+
+void FmtParser::setReplacementSubstr(std::size_t Len) {
+  if (Len == StrView::npos)
+    Len = FormatString.size();
+  this->ParsedReplacement = 
+    FmtReplacement(FormatString.substr(0, Len));
+}
+
+void FmtParser::setReplacementSubstr(std::size_t Pos, std::size_t Len) {
+  this->ParsedReplacement = 
+    FmtReplacement(FormatString.substr(Pos, Len));
+}
+
+StrView FmtParser::collectBraces() const {
+  const auto BraceEnd = FormatString.find_first_not_of('{');
+  if SLIMFMT_UNLIKELY(BraceEnd == StrView::npos)
+    return StrView();
+  return FormatString.substr(0, BraceEnd);
+}
 
-  return {Base, Extra};
+void FmtParser::report(FmtError Error, StrView Spec) const {
+  if SLIMFMT_LIKELY(!MuteErrors)
+    reportError(Error, Spec);
 }
 
-bool Formatter::parseReplacementSpec(StrView Spec) {
+bool FmtParser::parseReplacementSpec(StrView Spec) {
   char Pad = ' ';
   AlignType Side = AlignType::Default;
   std::size_t Align = 0;
   BaseSink  Base  = BaseType::Default;
   ExtraType Extra = ExtraType::Default;
-  StrView Data = Spec;
+  std::size_t Precision = 0;
   /// Use this to exit early without duplication.
   auto Finish = [&, this]() -> bool {
     this->ParsedReplacement = 
-      FmtReplacement(Data, Base, Extra, Side, Align, Pad);
+      FmtReplacement(Spec, Base, Extra, Side, Align, Pad);
+    this->ParsedReplacement.Precision = Precision;
     return true;
   };
+  /// The error has been reported. Use the default spec, so the
+  /// argument is still consumed and the rest of the string formatted.
+  auto Fail = [&, this]() -> bool {
+    this->ParsedReplacement = FmtReplacement(Spec, BaseType::Default,
+      ExtraType::Default, AlignType::Default, 0, ' ');
+    return false;
+  };
 
-  if (Spec.empty())
+  const char* Ptr = Spec.data();
+  const char* const End = Ptr + Spec.size();
+  if (Ptr == End)
     return Finish();
+
   /// Check if we have an align/width specifier.
-  if (Spec.front() == ':') {
-    if SLIMFMT_UNLIKELY(Spec.size() <= 1) {
+  if (*Ptr == ':') {
+    if SLIMFMT_UNLIKELY(End - Ptr < 2) {
+      this->report(FmtError::InvalidSpec, Spec);
       dbgassert(false && "Spec string not long enough!");
-      this->ParsedReplacement = FmtReplacement();
-      return false;
+      return Fail();
     }
-    Pad = Spec[1];
+    Pad = Ptr[1];
     if SLIMFMT_UNLIKELY(Pad < ' ' || Pad > 0x7F) {
+      this->report(FmtError::InvalidSpec, Spec);
       dbgassert(false && "Invalid padding type!");
       Pad = ' ';
     }
-    Spec.remove_prefix(2);
-    Side  = parseRSpecSide(Spec);
-    Align = parseRSpecAlign(Spec);
-    if (Spec.empty())
+    Ptr += 2;
+    if (Ptr != End && specLUT[*Ptr].Class == SpecClass::Side) {
+      Side = AlignType(specLUT[*Ptr].Value);
+      ++Ptr;
+    }
+    if (Ptr != End) {
+      switch (specLUT[*Ptr].Class) {
+        case SpecClass::Star:
+          // Dynamic align character
+          Align = FmtReplacement::dynamicAlign;
+          ++Ptr;
+          break;
+        case SpecClass::Digit:
+          Ptr = parseSpecInt(Ptr, End, Align);
+          if SLIMFMT_UNLIKELY(!Ptr) {
+            this->report(FmtError::InvalidWidth, Spec);
+            dbgassert(false && "Invalid width specifier!");
+            return Fail();
+          }
+          break;
+        case SpecClass::Percent:
+          break;
+        default:
+          this->report(FmtError::InvalidSpec, Spec);
+          dbgassert(false && "Invalid alignment specifier!");
+          return Fail();
+      }
+    }
+    if (Ptr == End)
       return Finish();
   }
+
   // The only possible format specifier now is %.
   // If it doesn't currently start with this, the
   // format specifier is invalid.
-  if SLIMFMT_UNLIKELY(Spec.front() != '%' || Spec.size() <= 1) {
+  if SLIMFMT_UNLIKELY(*Ptr != '%' || (End - Ptr) < 2) {
+    this->report(FmtError::InvalidSpec, Spec);
     dbgassert(false && "Invalid extra format specifier!");
-    this->ParsedReplacement = FmtReplacement();
-    return false;
+    return Fail();
+  }
+  ++Ptr;
+
+  bool HasBase = false;
+  while (Ptr != End) {
+    const SpecChar& C = specLUT[*Ptr++];
+    switch (C.Class) {
+      // Bases:
+      case SpecClass::Base: {
+        dbgassert(!HasBase && "Base will be overwritten!");
+        dbgassert(Extra == ExtraType::None &&
+          "Extra options must follow the base!");
+        Base = C.Value;
+        HasBase = true;
+        if (C.Upper)
+          Extra = ExtraType::Uppercase;
+        break;
+      }
+      // Arbitrary Radix:
+      case SpecClass::Radix: {
+        dbgassert(!HasBase && "Base will be overwritten!");
+        std::size_t Radix = 0;
+        Ptr = parseSpecInt(Ptr, End, Radix);
+        if SLIMFMT_UNLIKELY(!Ptr || Radix == 0 || Radix > 36) {
+          this->report(FmtError::InvalidBase, Spec);
+          dbgassert(false && "Base out of range!");
+          return Fail();
+        }
+        Base = BaseSink(std::int64_t(Radix));
+        HasBase = true;
+        if (C.Upper)
+          Extra = ExtraType::Uppercase;
+        break;
+      }
+
+      // Extra:
+      case SpecClass::Extra: {
+        dbgassert((Extra == ExtraType::None || 
+          Extra == ExtraType::Uppercase) &&
+          "Type specifier will be overwritten!");
+        Extra = ExtraType(C.Value);
+        // Pointers default to hex.
+        if (Extra == ExtraType::Ptr && !HasBase)
+          Base = BaseType::Hex;
+        break;
+      }
+
+      // Precision:
+      case SpecClass::Dot: {
+        Ptr = parseSpecInt(Ptr, End, Precision);
+        if SLIMFMT_UNLIKELY(!Ptr) {
+          this->report(FmtError::InvalidPrecision, Spec);
+          dbgassert(false && "Invalid precision!");
+          return Fail();
+        }
+        if SLIMFMT_UNLIKELY(Precision > 19) {
+          this->report(FmtError::InvalidPrecision, Spec);
+          dbgassert(false && "Precision out of range!");
+          return Fail();
+        }
+        break;
+      }
+
+      default:
+        this->report(FmtError::InvalidSpec, Spec);
+        dbgassert(false && "Invalid spec option!");
+        return Fail();
+    }
   }
 
-  std::tie(Base, Extra) = parseRSpecOptions(Spec.substr(1));
+  dbgassert((Precision == 0 ||
+    Extra == ExtraType::Fixed || Extra == ExtraType::FixedTrim) &&
+    "Precision requires %q or %g!");
   return Finish();
 }
 
-bool Formatter::parseNextReplacement() {
+bool FmtParser::parseNextReplacement() {
   if (FormatString.empty())
     return false;
   
@@ -1179,9 +2342,10 @@ bool Formatter::parseNextReplacement() {
 
   std::size_t BraceClose = FormatString.find_first_of('}');
   if (BraceClose == StrView::npos) {
+    this->report(FmtError::Unterminated, FormatString);
     dbgassert(false && "Unterminated format specifier. "
       "Use {{ to escape a sequence.");
-    this->setReplacementSubstr();
+    this->ParsedReplacement = FmtReplacement();
     FormatString = "";
     return false;
   }
@@ -1199,7 +2363,10 @@ bool Formatter::parseNextReplacement() {
 
   StrView Spec = FormatString.substr(1, BraceClose - 1);
   FormatString.remove_prefix(BraceClose + 1);
-  return parseReplacementSpec(Spec);
+  if SLIMFMT_UNLIKELY(!parseReplacementSpec(Spec))
+    // The replacement is still used, with the default spec.
+    this->HasErrors = true;
+  return true;
 }
 
 //=== Core ===//
@@ -1244,73 +2411,1194 @@ namespace {
   };
 } // namespace `anonymous`
 
+//=== Precompiled ===//
+
+namespace {
+  /// The head of the list of generated tables. Constant initialized,
+  /// so blocks can be linked in from any static initializer.
+  static std::atomic<PrecompiledBlock*> precompiledHead {nullptr};
+
+  /// Loads up to 8 bytes as little endian, independent of the host,
+  /// so `slimfmt-extract` can be run when cross compiling.
+  static std::uint64_t loadHashChunk(const char* Ptr, std::size_t Len) {
+    std::uint64_t V = 0;
+    for (std::size_t Ix = 0; Ix < Len; ++Ix)
+      V |= std::uint64_t(static_cast<unsigned char>(Ptr[Ix])) << (Ix * 8);
+    return V;
+  }
+
+  static FmtReplacement decodeSpec(
+   const PrecompiledSpec& Spec, StrView Str) {
+    const StrView Data = Str.substr(Spec.Offset, Spec.Size);
+    if (Spec.Type == FmtReplacement::Literal)
+      return FmtReplacement(Data);
+    FmtReplacement Out(Data, 
+      RawBaseType(Spec.Base), ExtraType(Spec.Extra),
+      AlignType(Spec.Side), Spec.Align, Spec.Pad);
+    if (Spec.Align == ~std::uint32_t(0))
+      Out.Align = FmtReplacement::dynamicAlign;
+    Out.Precision = Spec.Precision;
+    return Out;
+  }
+} // namespace `anonymous`
+
+sfmt::PrecompiledBlock::PrecompiledBlock(
+ const PrecompiledFormat* Formats, std::size_t Count) :
+ Formats(Formats), Count(Count) {
+  PrecompiledBlock* Head = precompiledHead.load(std::memory_order_relaxed);
+  do {
+    this->Next = Head;
+  } while (!precompiledHead.compare_exchange_weak(
+    Head, this, std::memory_order_release, std::memory_order_relaxed));
+}
+
+std::uint64_t sfmt::hashFormatString(StrView Str) {
+  const char* Ptr = Str.data();
+  std::size_t Len = Str.size();
+  std::uint64_t H = 0x9E3779B97F4A7C15ULL ^ Len;
+  for (; Len >= 8; Ptr += 8, Len -= 8) {
+    H = (H ^ loadHashChunk(Ptr, 8)) * 0xFF51AFD7ED558CCDULL;
+    H ^= H >> 32;
+  }
+  if (Len != 0) {
+    H = (H ^ loadHashChunk(Ptr, Len)) * 0xFF51AFD7ED558CCDULL;
+    H ^= H >> 32;
+  }
+  H *= 0xC4CEB9FE1A85EC53ULL;
+  return H ^ (H >> 29);
+}
+
+const PrecompiledFormat* sfmt::findPrecompiled(StrView Str) {
+  const PrecompiledBlock* Block = 
+    precompiledHead.load(std::memory_order_acquire);
+  if SLIMFMT_LIKELY(!Block)
+    return nullptr;
+  const std::uint64_t Hash = hashFormatString(Str);
+  for (; Block; Block = Block->Next) {
+    const PrecompiledFormat* const End = Block->Formats + Block->Count;
+    const PrecompiledFormat* Pre = std::lower_bound(
+      Block->Formats, End, Hash,
+      [] (const PrecompiledFormat& Lhs, std::uint64_t Rhs) {
+        return Lhs.Hash < Rhs;
+      });
+    // Compare the contents, in case of collisions.
+    for (; Pre != End && Pre->Hash == Hash; ++Pre) {
+      if (Pre->Size == Str.size() &&
+       std::memcmp(Pre->Str, Str.data(), Str.size()) == 0)
+        return Pre;
+    }
+  }
+  return nullptr;
+}
+
+//=== Validation ===//
+
+#if SLIMFMT_VALIDATE
+namespace {
+  /// A lock-free set of call sites which have already been validated.
+  /// When full, call sites are just validated every time.
+  struct CallSiteCache {
+    static constexpr std::size_t size = 1024;
+    static constexpr std::size_t maxProbes = 8;
+  public:
+    /// Inserts `Key` if it isn't present.
+    /// @return `true` if the key was already present.
+    bool testAndSet(std::uint64_t Key) {
+      Key |= 1U;
+      for (std::size_t Ix = 0; Ix < maxProbes; ++Ix) {
+        auto& Slot = Slots[(Key + Ix) & (size - 1)];
+        std::uint64_t Old = Slot.load(std::memory_order_relaxed);
+        if SLIMFMT_LIKELY(Old == Key)
+          return true;
+        if (Old == 0 && Slot.compare_exchange_strong(
+         Old, Key, std::memory_order_relaxed))
+          return false;
+        if (Old == Key)
+          return true;
+      }
+      return false;
+    }
+
+  private:
+    std::atomic<std::uint64_t> Slots[size] {};
+  };
+
+  static CallSiteCache callSites {};
+
+  static std::uint64_t mixKey(std::uint64_t V) {
+    V ^= V >> 33;
+    V *= 0xFF51AFD7ED558CCDULL;
+    V ^= V >> 33;
+    return V;
+  }
+} // namespace `anonymous`
+#endif // SLIMFMT_VALIDATE
+
+/// Checks if `Value` can be formatted with the extra option.
+static bool isValidForExtra(const FmtValue& Value, ExtraType Extra) {
+  if (Value.isGenericType())
+    return true;
+  switch (Extra) {
+    case ExtraType::Char:
+    case ExtraType::LinePrefix:
+    case ExtraType::UrlEncode:
+    case ExtraType::HtmlEscape:
+      return Value.isCharType() || Value.isStrType();
+    case ExtraType::Fixed:
+    case ExtraType::FixedTrim:
+    case ExtraType::Name:
+      return Value.isIntType();
+    default:
+      return true;
+  }
+}
+
+bool Formatter::validate(StrView Str, FmtValue::List Values) {
+  FmtParser Parser {Str};
+  FmtValueSpan Vs {Values};
+  bool IsValid = true;
+  auto Take = [&Vs, &IsValid] (const FmtReplacement& Spec, 
+   bool(FmtValue::*Check)(bool) const, bool Permissive) -> bool {
+    const FmtValue* Value = Vs.take();
+    if SLIMFMT_UNLIKELY(!Value) {
+      reportError(FmtError::MissingArgument, Spec.Data);
+      return false;
+    }
+    if SLIMFMT_UNLIKELY(!(Value->*Check)(Permissive)) {
+      reportError(FmtError::InvalidArgument, Spec.Data);
+      IsValid = false;
+    }
+    return true;
+  };
+
+  while (Parser.parseNextReplacement()) {
+    const FmtReplacement& Spec = Parser.getLastReplacement();
+    if (Spec.isLiteral())
+      continue;
+    // The parser has already reported these.
+    if SLIMFMT_UNLIKELY(Spec.isEmpty() || Spec.Base == BaseType::Invalid)
+      return false;
+    if (Spec.hasDynAlign() && !Take(Spec, &FmtValue::isIntType, true))
+      return false;
+    if (Spec.hasLinePrefix() && !Take(Spec, &FmtValue::isStrType, false))
+      return false;
+    const FmtValue* Value = Vs.take();
+    if SLIMFMT_UNLIKELY(!Value) {
+      reportError(FmtError::MissingArgument, Spec.Data);
+      return false;
+    }
+    if SLIMFMT_UNLIKELY(!isValidForExtra(*Value, Spec.Extra)) {
+      reportError(FmtError::InvalidArgument, Spec.Data);
+      IsValid = false;
+    }
+  }
+
+  if (Parser.getLastReplacement().isEmpty() && !Str.empty())
+    return false;
+  if SLIMFMT_UNLIKELY(!Vs.isEmpty()) {
+    reportError(FmtError::ExtraArgument, StrView());
+    return false;
+  }
+  return IsValid && !Parser.hasErrors();
+}
+
 void Formatter::parseWith(FmtValue::List Values) {
+#if SLIMFMT_VALIDATE
+  {
+    // Validate each call site once, keyed by the address
+    // and size of the string, and the argument types.
+    std::uint64_t Key = mixKey(
+      reinterpret_cast<std::uintptr_t>(FormatString.data()) ^
+      (std::uint64_t(FormatString.size()) << 48));
+    for (const FmtValue& Value : Values)
+      Key = (Key * 0x100000001B3ULL) ^ Value.Type;
+    // Validation reports everything formatting would,
+    // so only report errors once.
+    if SLIMFMT_UNLIKELY(!callSites.testAndSet(mixKey(Key))) {
+      Formatter::validate(FormatString, Values);
+      this->MuteErrors = true;
+    }
+  }
+#endif // SLIMFMT_VALIDATE
   FmtValueSpan Vs {Values};
-  while (this->parseNextReplacement()) {
+  // Use the replacements parsed at build time if there are any.
+  // The format string isn't consumed in this case.
+  const PrecompiledFormat* Pre = findPrecompiled(FormatString);
+  std::uint32_t PreIx = 0;
+  auto NextReplacement = [&, this]() -> bool {
+    if SLIMFMT_LIKELY(!Pre)
+      return this->parseNextReplacement();
+    if (PreIx == Pre->Count)
+      return false;
+    ParsedReplacement = decodeSpec(Pre->Specs[PreIx++], FormatString);
+    return true;
+  };
+
+  // Writes go through a local cursor, which is only committed
+  // when the buffer is used directly.
+  BufCursor Cur {Buf};
+  while (NextReplacement()) {
     if SLIMFMT_UNLIKELY(ParsedReplacement.isEmpty()) {
       dbgassert(false && "Parse Failure!");
       return;
     }
     // Check if format is normal string.
     if (ParsedReplacement.isLiteral()) {
-      Buf.appendStr(ParsedReplacement.Data);
+      const StrView Data = ParsedReplacement.Data;
+      Cur.append(Data.data(), Data.size());
       continue;
     }
     // If the format specifier used dynamic alignment (*),
     // we extract an argument as an integer, and use that as the value.
     if (ParsedReplacement.hasDynAlign()) {
-      dbgassert(Vs.canTakePair() && "Not enough arguments for dynamic align!");
+      if SLIMFMT_UNLIKELY(!Vs.canTakePair()) {
+        this->report(FmtError::MissingArgument, ParsedReplacement.Data);
+        dbgassert(false && "Not enough arguments for dynamic align!");
+        return;
+      }
       const FmtValue* Align = Vs.take();
       dbgassert(Align->isIntType(true) && "Invalid dynamic alignment type!");
       ParsedReplacement.Align = Align->getInt(true);
     }
+    // If the format specifier used a line prefix (%l),
+    // we extract an argument as a string, and insert it after newlines.
+    if (ParsedReplacement.hasLinePrefix()) {
+      if SLIMFMT_UNLIKELY(!Vs.canTakePair()) {
+        this->report(FmtError::MissingArgument, ParsedReplacement.Data);
+        dbgassert(false && "Not enough arguments for line prefix!");
+        return;
+      }
+      const FmtValue* Prefix = Vs.take();
+      dbgassert(Prefix->isStrType() && "Invalid line prefix type!");
+      auto [Str, Len] = Prefix->getStr();
+      ParsedReplacement.Prefix = StrView(Str ? Str : "", Len);
+    }
     // Use the value as the dispatcher for parsing.
     // There should be at least one argument here.
     if SLIMFMT_UNLIKELY(!Vs.canTake()) {
+      this->report(FmtError::MissingArgument, ParsedReplacement.Data);
       dbgassert(false && "Not enough arguments!");
       return;
     }
     const FmtValue* Value = Vs.take();
-    if (!this->formatValue(*Value))
+    if SLIMFMT_LIKELY(this->formatSimple(*Value, Cur))
+      continue;
+    Cur.commit();
+    const bool Ok = this->formatValue(*Value);
+    Cur.reload();
+    if (!Ok)
       // An error occurred. Stop parsing.
       return;
   }
 
-  dbgassert(Vs.isEmpty() && "Too many arguments passed to formatter!");
+  // Don't report the arguments left over from a parse failure.
+  if SLIMFMT_UNLIKELY(!Vs.isEmpty() && !ParsedReplacement.isEmpty()) {
+    this->report(FmtError::ExtraArgument, StrView());
+    dbgassert(false && "Too many arguments passed to formatter!");
+  }
 }
 
-//======================================================================//
-// API
-//======================================================================//
-
-namespace {
+//=== Logfmt ===//
 
-struct NullPrinter : public BasePrinter {
-  void printerRun(
-   StrView Str, SmallBufBase& Buf, 
-   FmtValue::List Values) const override {
-#ifndef NDEBUG
-    Formatter Fmt {Buf, Str};
-    Fmt.parseWith(Values);
-#endif
+void Formatter::writeLogfmtStr(StrView Str) const {
+  if SLIMFMT_LIKELY(!needsLogfmtQuotes(Str.data(), Str.size())) {
+    Buf.appendStr(Str);
+    return;
   }
+  Buf.pushBack('"');
+  appendEscaped<JsonEscaper>(Buf, Str.data(), Str.size());
+  Buf.pushBack('"');
+}
 
-  void defaultWrite(SmallBufBase&) const override {}
-};
+void Formatter::writeLogfmtValue(const FmtValue& Value) const {
+  // Numbers and pointers never need quotes.
+  if (Value.isIntType() || Value.isPtrType()) {
+    this->write(Value);
+    return;
+  }
+  if (Value.isStrType()) {
+    auto [Str, Len] = Value.getStr();
+    this->writeLogfmtStr(StrView(Str ? Str : "", Len));
+    return;
+  }
+  if (Value.isCharType()) {
+    const char C = Value.getChar();
+    this->writeLogfmtStr(StrView(&C, 1));
+    return;
+  }
+  // Generics have to be formatted before they can be checked.
+  SmallBuf<64> Tmp;
+  Formatter TmpFmt {Tmp, ""};
+  TmpFmt.write(Value);
+  this->writeLogfmtStr(StrView(Tmp.data(), Tmp.size()));
+}
 
-struct TestPrinter : public NullPrinter {
-  void printerRun(
-   StrView Str, SmallBufBase& Buf, 
-   FmtValue::List Values) const override {
-    Formatter Fmt {Buf, Str};
-    Fmt.parseWith(Values);
+void Formatter::logfmtWith(StrView Message, FmtValue::List Values) {
+  FmtValueSpan Vs {Values};
+  // Use the default spec for every value.
+  this->ParsedReplacement = FmtReplacement({}, BaseType::Default,
+    ExtraType::Default, AlignType::Default, 0);
+  bool IsFirst = true;
+  if (!Message.empty()) {
+    Buf.append("msg=", 4);
+    this->writeLogfmtStr(Message);
+    IsFirst = false;
   }
-};
 
-template <bool UseErr, bool AddLine>
-struct OutPrinter : public BasePrinter {
-  void printerRun(
-   StrView Str, SmallBufBase& Buf, 
+  while (Vs.canTake()) {
+    const FmtValue* Key = Vs.take();
+    const FmtValue* Value = Vs.canTake() ? Vs.take() : nullptr;
+    StrView KeyStr;
+    if SLIMFMT_LIKELY(Key->isStrType(true)) {
+      auto [Str, Len] = Key->getStr();
+      KeyStr = StrView(Str ? Str : "", Len);
+    }
+    // Keys are written as is, so they can't need quotes.
+    if SLIMFMT_UNLIKELY(!Key->isStrType(true) || KeyStr.empty()
+     || needsLogfmtQuotes(KeyStr.data(), KeyStr.size())) {
+      this->report(FmtError::InvalidArgument, KeyStr);
+      dbgassert(false && "Invalid logfmt key!");
+      continue;
+    }
+    if SLIMFMT_UNLIKELY(!Value) {
+      this->report(FmtError::MissingArgument, KeyStr);
+      dbgassert(false && "Logfmt key is missing a value!");
+      return;
+    }
+    if (!IsFirst)
+      Buf.pushBack(' ');
+    IsFirst = false;
+    Buf.appendStr(KeyStr);
+    Buf.pushBack('=');
+    this->writeLogfmtValue(*Value);
+  }
+}
+
+//======================================================================//
+// Scanner
+//======================================================================//
+
+long long ScanValue::getInt() const {
+  switch (this->Type) {
+   case SIntType: {
+    switch (this->Size) {
+     case 1: return *static_cast<const std::int8_t*>(Data);
+     case 2: return *static_cast<const std::int16_t*>(Data);
+     case 4: return *static_cast<const std::int32_t*>(Data);
+     default: return *static_cast<const std::int64_t*>(Data);
+    }
+   }
+   case UIntType: {
+    switch (this->Size) {
+     case 1: return *static_cast<const std::uint8_t*>(Data);
+     case 2: return *static_cast<const std::uint16_t*>(Data);
+     case 4: return *static_cast<const std::uint32_t*>(Data);
+     default: return (long long)*static_cast<const std::uint64_t*>(Data);
+    }
+   }
+   default:
+    dbgassert(false && "Invalid integer type!");
+    return 0;
+  }
+}
+
+template <typename T>
+static inline void scanStore(void* Data, std::uint64_t Value) {
+  *static_cast<T*>(Data) = static_cast<T>(Value);
+}
+
+bool ScanValue::setInt(unsigned long long Magnitude, bool IsNegative) const {
+  dbgassert(this->isIntType() && "Invalid integer type!");
+  const int Bits = this->Size * CHAR_BIT;
+  if (this->Type == UIntType) {
+    const std::uint64_t Max = ~std::uint64_t(0) >> (64 - Bits);
+    if SLIMFMT_UNLIKELY(Magnitude > Max || (IsNegative && Magnitude))
+      return false;
+  } else {
+    // The negative range is one larger than the positive.
+    const std::uint64_t Max = 
+      (std::uint64_t(1) << (Bits - 1)) - !IsNegative;
+    if SLIMFMT_UNLIKELY(Magnitude > Max)
+      return false;
+    if (IsNegative)
+      Magnitude = std::uint64_t(0) - Magnitude;
+  }
+
+  switch (this->Size) {
+   case 1: scanStore<std::uint8_t>(Data, Magnitude);  break;
+   case 2: scanStore<std::uint16_t>(Data, Magnitude); break;
+   case 4: scanStore<std::uint32_t>(Data, Magnitude); break;
+   default: scanStore<std::uint64_t>(Data, Magnitude);
+  }
+  return true;
+}
+
+void ScanValue::setStr(StrView Str) const {
+  if (this->Type == StdStringType)
+    static_cast<std::string*>(Data)->assign(Str.data(), Str.size());
+  else if (this->Type == StringViewType)
+    *static_cast<StrView*>(Data) = Str;
+  else
+    dbgassert(false && "Invalid string type!");
+}
+
+void ScanValue::setChar(char C) const {
+  dbgassert(this->Type == CharType && "Invalid character type!");
+  *static_cast<char*>(Data) = C;
+}
+
+bool Scanner::matchLiteral(StrView Literal) {
+  const std::size_t Len = Literal.size();
+  if SLIMFMT_UNLIKELY(Input.size() < Len)
+    return false;
+  if (std::memcmp(Input.data(), Literal.data(), Len) != 0)
+    return false;
+  Input.remove_prefix(Len);
+  return true;
+}
+
+std::size_t Scanner::findFieldEnd(StrView Field) const {
+  // Look ahead without consuming the format string.
+  FmtParser Next = static_cast<const FmtParser&>(*this);
+  if (!Next.parseNextReplacement())
+    return Field.size();
+  const FmtReplacement& After = Next.getLastReplacement();
+  if SLIMFMT_LIKELY(After.isLiteral() && !After.Data.empty()) {
+    const std::size_t Pos = Field.find(After.Data);
+    return std::min(Pos, Field.size());
+  }
+  // Adjacent replacements are ambiguous, so stop at whitespace.
+  const std::size_t Pos = Field.find_first_of(" \t\r\n");
+  return std::min(Pos, Field.size());
+}
+
+std::size_t Scanner::scanInt(StrView Field,
+ std::uint64_t& Magnitude, bool& IsNegative) const {
+  const char* const Begin = Field.data();
+  const char* const End = Begin + Field.size();
+  const char* Ptr = Begin;
+  IsNegative = false;
+  if (Ptr != End && (*Ptr == '-' || *Ptr == '+'))
+    IsNegative = (*Ptr++ == '-');
+
+  Ptr = baseDispatch(0, ParsedReplacement.Base,
+  [&Magnitude, Ptr, End] (auto Fmt, std::uint64_t) {
+    return Fmt.Parse(Ptr, End, Magnitude);
+  });
+
+  if SLIMFMT_UNLIKELY(!Ptr)
+    return 0;
+  return std::size_t(Ptr - Begin);
+}
+
+/// Removes padding from a fixed width field, keeping at least one character.
+static StrView trimPadding(StrView Field, const FmtReplacement& Spec) {
+  if (Spec.Side != AlignType::Left) {
+    const std::size_t Pos = Field.find_first_not_of(Spec.Pad);
+    Field.remove_prefix(std::min(Pos, Field.size() - 1));
+  }
+  if (Spec.Side != AlignType::Right && !Field.empty()) {
+    const std::size_t Pos = Field.find_last_not_of(Spec.Pad);
+    Field = Field.substr(0, (Pos == StrView::npos) ? 1 : Pos + 1);
+  }
+  return Field;
+}
+
+bool Scanner::scanValue(const ScanValue& Value) {
+  auto& Spec = ParsedReplacement;
+  dbgassert(!Spec.hasLinePrefix() && !Spec.isEscaped() 
+    && "Option is not supported when scanning!");
+  
+  // Fixed width fields are exactly `Align` characters.
+  const bool IsFixed = (Spec.Align != 0);
+  StrView Field = Input;
+  if (IsFixed) {
+    if SLIMFMT_UNLIKELY(Input.size() < Spec.Align || Spec.Align == 0)
+      return false;
+    Field = trimPadding(Input.substr(0, Spec.Align), Spec);
+  }
+
+  std::size_t Used = 0;
+  std::uint64_t Magnitude = 0;
+  bool IsNegative = false;
+  if (Value.isIntType()) {
+    Used = this->scanInt(Field, Magnitude, IsNegative);
+    if SLIMFMT_UNLIKELY(Used == 0)
+      return false;
+  } else if (Value.Type == ScanValue::CharType) {
+    if SLIMFMT_UNLIKELY(Field.empty())
+      return false;
+    Used = 1;
+  } else {
+    if (Spec.Extra == ExtraType::Char)
+      Field = Field.substr(0, 1);
+    else if (!IsFixed)
+      Field = Field.substr(0, this->findFieldEnd(Field));
+    Used = Field.size();
+  }
+
+  // The value must use the whole field. Nothing is assigned
+  // until it's known to match.
+  if SLIMFMT_UNLIKELY(IsFixed && Used != Field.size())
+    return false;
+  if (Value.isIntType()) {
+    if SLIMFMT_UNLIKELY(!Value.setInt(Magnitude, IsNegative))
+      return false;
+  } else if (Value.Type == ScanValue::CharType) {
+    Value.setChar(Field.front());
+  } else {
+    Value.setStr(Field);
+  }
+  Input.remove_prefix(IsFixed ? Spec.Align : Used);
+  return true;
+}
+
+std::size_t Scanner::scanWith(ScanValue::List Values) {
+  const ScanValue* Vs = Values.begin();
+  const ScanValue* const VsEnd = Values.end();
+  std::size_t Count = 0;
+  while (this->parseNextReplacement()) {
+    if SLIMFMT_UNLIKELY(ParsedReplacement.isEmpty()) {
+      dbgassert(false && "Parse Failure!");
+      return Count;
+    }
+    // Literals must match exactly.
+    if (ParsedReplacement.isLiteral()) {
+      if (!this->matchLiteral(ParsedReplacement.Data))
+        return Count;
+      continue;
+    }
+    // Dynamic alignment reads the width from the argument.
+    if (ParsedReplacement.hasDynAlign()) {
+      if SLIMFMT_UNLIKELY((VsEnd - Vs) < 2) {
+        this->report(FmtError::MissingArgument, ParsedReplacement.Data);
+        dbgassert(false && "Not enough arguments for dynamic align!");
+        return Count;
+      }
+      if SLIMFMT_UNLIKELY(!Vs->isIntType()) {
+        this->report(FmtError::InvalidArgument, ParsedReplacement.Data);
+        dbgassert(false && "Invalid dynamic alignment type!");
+        return Count;
+      }
+      ParsedReplacement.Align = std::size_t((Vs++)->getInt());
+    }
+    if SLIMFMT_UNLIKELY(Vs == VsEnd) {
+      this->report(FmtError::MissingArgument, ParsedReplacement.Data);
+      dbgassert(false && "Not enough arguments!");
+      return Count;
+    }
+    // Input which doesn't match isn't an error in the format.
+    if (!this->scanValue(*Vs++))
+      return Count;
+    ++Count;
+  }
+
+  // Only reached once the whole format string has been used.
+  if SLIMFMT_UNLIKELY(Vs != VsEnd && !ParsedReplacement.isEmpty()) {
+    this->report(FmtError::ExtraArgument, StrView());
+    dbgassert(false && "Too many arguments passed to scanner!");
+  }
+  return Count;
+}
+
+//======================================================================//
+// JsonWriter
+//======================================================================//
+
+bool JsonWriter::separate() {
+  if SLIMFMT_UNLIKELY(Dropped)
+    return false;
+  if (this->AfterKey) {
+    this->AfterKey = false;
+    return true;
+  }
+  dbgassert(!(IsObject & (1ULL << Depth)) && "Expected a key!");
+  // Top level values aren't separated.
+  if SLIMFMT_UNLIKELY(Depth == 0)
+    return true;
+  const std::uint64_t Bit = (1ULL << Depth);
+  if (HasElement & Bit)
+    Buf.pushBack(',');
+  HasElement |= Bit;
+  return true;
+}
+
+void JsonWriter::writeString(StrView Str) {
+  Buf.pushBack('"');
+  appendEscaped<JsonEscaper>(Buf, Str.data(), Str.size());
+  Buf.pushBack('"');
+}
+
+void JsonWriter::push(char Open, bool IsObj) {
+  // The level bits run out past 63, so deeper levels are written
+  // as `null`, and everything in them is dropped.
+  if SLIMFMT_UNLIKELY(Depth >= 63 || Dropped) {
+    if (Dropped++ == 0) {
+      reportError(FmtError::InvalidArgument, StrView(&Open, 1));
+      this->separate();
+      Buf.append("null", 4);
+    }
+    dbgassert(false && "JSON nested too deeply!");
+    return;
+  }
+  this->separate();
+  Buf.pushBack(Open);
+  const std::uint64_t Bit = (1ULL << ++Depth);
+  HasElement &= ~Bit;
+  IsObject = IsObj ? (IsObject | Bit) : (IsObject & ~Bit);
+}
+
+void JsonWriter::pop(char Close, [[maybe_unused]] bool IsObj) {
+  if SLIMFMT_UNLIKELY(Dropped) {
+    --Dropped;
+    return;
+  }
+  dbgassert(Depth > 0 && "Unbalanced JSON!");
+  dbgassert(!AfterKey && "Key is missing a value!");
+  dbgassert(bool(IsObject & (1ULL << Depth)) == IsObj 
+    && "Mismatched JSON brackets!");
+  --Depth;
+  Buf.pushBack(Close);
+}
+
+JsonWriter& JsonWriter::beginObject() {
+  this->push('{', true);
+  return *this;
+}
+
+JsonWriter& JsonWriter::endObject() {
+  this->pop('}', true);
+  return *this;
+}
+
+JsonWriter& JsonWriter::beginArray() {
+  this->push('[', false);
+  return *this;
+}
+
+JsonWriter& JsonWriter::endArray() {
+  this->pop(']', false);
+  return *this;
+}
+
+JsonWriter& JsonWriter::key(StrView Key) {
+  if SLIMFMT_UNLIKELY(Dropped)
+    return *this;
+  dbgassert((IsObject & (1ULL << Depth)) && "Keys must be in an object!");
+  dbgassert(!AfterKey && "Key is missing a value!");
+  const std::uint64_t Bit = (1ULL << Depth);
+  if (HasElement & Bit)
+    Buf.pushBack(',');
+  HasElement |= Bit;
+  this->writeString(Key);
+  Buf.pushBack(':');
+  this->AfterKey = true;
+  return *this;
+}
+
+JsonWriter& JsonWriter::value(StrView Str) {
+  if SLIMFMT_UNLIKELY(!this->separate())
+    return *this;
+  this->writeString(Str);
+  return *this;
+}
+
+JsonWriter& JsonWriter::value(const char* Str) {
+  if SLIMFMT_UNLIKELY(!Str)
+    return this->value(nullptr);
+  return this->value(StrView(Str));
+}
+
+JsonWriter& JsonWriter::value(long long V) {
+  if SLIMFMT_UNLIKELY(!this->separate())
+    return *this;
+  auto Abs = static_cast<std::uint64_t>(V);
+  if (V < 0) {
+    Buf.pushBack('-');
+    Abs = (std::uint64_t(0) - Abs);
+  }
+  IntFormat<10>::Write(Buf, Abs);
+  return *this;
+}
+
+JsonWriter& JsonWriter::value(unsigned long long V) {
+  if SLIMFMT_UNLIKELY(!this->separate())
+    return *this;
+  IntFormat<10>::Write(Buf, V);
+  return *this;
+}
+
+JsonWriter& JsonWriter::value(bool V) {
+  if SLIMFMT_UNLIKELY(!this->separate())
+    return *this;
+  Buf.appendStr(V ? StrView("true") : StrView("false"));
+  return *this;
+}
+
+JsonWriter& JsonWriter::value(std::nullptr_t) {
+  if SLIMFMT_UNLIKELY(!this->separate())
+    return *this;
+  Buf.append("null", 4);
+  return *this;
+}
+
+JsonWriter& JsonWriter::rawValue(StrView Json) {
+  if SLIMFMT_UNLIKELY(!this->separate())
+    return *this;
+  Buf.appendStr(Json);
+  return *this;
+}
+
+//======================================================================//
+// Network
+//======================================================================//
+
+namespace {
+  /// Each octet as `[0-9]{1,3}.`, padded to 4 bytes.
+  struct OctetLUT {
+    constexpr OctetLUT() {
+      for (int B = 0; B < 256; ++B) {
+        int Len = 0;
+        if (B >= 100)
+          Str[B][Len++] = char('0' + B / 100);
+        if (B >= 10)
+          Str[B][Len++] = char('0' + (B / 10) % 10);
+        Str[B][Len++] = char('0' + B % 10);
+        Str[B][Len] = '.';
+        Size[B] = std::uint8_t(Len);
+      }
+    }
+  public:
+    char Str[256][4] {};
+    std::uint8_t Size[256] {};
+  };
+
+  static constexpr OctetLUT octetLUT {};
+
+  /// Writes `Addr` as a dotted quad, with 1 byte of slack.
+  /// @return The end of the address.
+  char* writeIPv4(char* Out, std::uint32_t Addr) {
+    for (int Shift = 24; Shift >= 0; Shift -= 8) {
+      const unsigned B = (Addr >> Shift) & 0xFFU;
+      std::memcpy(Out, octetLUT.Str[B], 4);
+      Out += octetLUT.Size[B] + 1;
+    }
+    // Drop the trailing dot.
+    return Out - 1;
+  }
+
+  /// Expands each byte of `In` into two hex digits.
+  /// `Out` must have room for `Len * 2` characters.
+  void hexExpand(char* Out, const std::uint8_t* In,
+   std::size_t Len, bool Upper) {
+    std::size_t Ix = 0;
+#if SLIMFMT_SSE2
+    const __m128i Low  = _mm_set1_epi8(0x0F);
+    const __m128i Nine = _mm_set1_epi8(9);
+    const __m128i Zero = _mm_set1_epi8('0');
+    const __m128i Alpha = _mm_set1_epi8(char((Upper ? 'A' : 'a') - '0' - 10));
+    for (; Ix + 8 <= Len; Ix += 8) {
+      const __m128i Bytes = _mm_loadl_epi64(
+        reinterpret_cast<const __m128i*>(In + Ix));
+      const __m128i Hi = _mm_and_si128(_mm_srli_epi16(Bytes, 4), Low);
+      const __m128i Lo = _mm_and_si128(Bytes, Low);
+      // Interleave so the high nibble comes first.
+      const __m128i Nibbles = _mm_unpacklo_epi8(Hi, Lo);
+      const __m128i IsAlpha = _mm_cmpgt_epi8(Nibbles, Nine);
+      const __m128i Chars = _mm_add_epi8(_mm_add_epi8(Nibbles, Zero),
+        _mm_and_si128(IsAlpha, Alpha));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(Out + Ix * 2), Chars);
+    }
+#endif // SLIMFMT_SSE2
+    const char* Digits = Upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    for (; Ix < Len; ++Ix) {
+      Out[Ix * 2]     = Digits[In[Ix] >> 4];
+      Out[Ix * 2 + 1] = Digits[In[Ix] & 0xF];
+    }
+  }
+
+  /// Gets the longest run of set bits as `{Start, Len}`,
+  /// preferring the first run on ties.
+  struct ZeroRunLUT {
+    constexpr ZeroRunLUT() {
+      for (int Mask = 0; Mask < 256; ++Mask) {
+        int Best = 0, BestLen = 0;
+        for (int Ix = 0; Ix < 8;) {
+          if (!(Mask & (1 << Ix))) {
+            ++Ix;
+            continue;
+          }
+          int End = Ix;
+          while (End < 8 && (Mask & (1 << End)))
+            ++End;
+          if (End - Ix > BestLen) {
+            Best = Ix;
+            BestLen = End - Ix;
+          }
+          Ix = End;
+        }
+        Start[Mask] = std::uint8_t(Best);
+        Size[Mask]  = std::uint8_t(BestLen);
+      }
+    }
+  public:
+    std::uint8_t Start[256] {};
+    std::uint8_t Size[256] {};
+  };
+
+  static constexpr ZeroRunLUT zeroRunLUT {};
+
+  /// Gets a bit for every 16-bit group which is zero.
+  unsigned zeroGroupMask(const std::uint8_t* Bytes) {
+#if SLIMFMT_SSE2
+    const __m128i Chunk = loadChunk(reinterpret_cast<const char*>(Bytes));
+    const __m128i Zeros = _mm_cmpeq_epi16(Chunk, _mm_setzero_si128());
+    // Narrow each group to a byte, then take the sign bits.
+    return unsigned(_mm_movemask_epi8(_mm_packs_epi16(Zeros, Zeros))) & 0xFFU;
+#else
+    unsigned Mask = 0;
+    for (int Ix = 0; Ix < 8; ++Ix) {
+      if ((Bytes[Ix * 2] | Bytes[Ix * 2 + 1]) == 0)
+        Mask |= (1U << Ix);
+    }
+    return Mask;
+#endif // SLIMFMT_SSE2
+  }
+
+  /// Writes a group without leading zeros.
+  char* writeIPv6Group(char* Out, unsigned Group, const char* Digits) {
+    const int Len = 1 + (Group >= 0x10) + (Group >= 0x100) + (Group >= 0x1000);
+    for (int Ix = Len - 1; Ix >= 0; --Ix) {
+      Out[Ix] = Digits[Group & 0xF];
+      Group >>= 4;
+    }
+    return Out + Len;
+  }
+
+  /// Writes `Bytes` as described in RFC 5952.
+  /// @return The end of the address.
+  char* writeIPv6(char* Out, const std::uint8_t* Bytes, bool Upper) {
+    const unsigned Mask = zeroGroupMask(Bytes);
+    // IPv4 mapped addresses use a dotted quad.
+    if ((Mask & 0x3FU) == 0x1FU && Bytes[10] == 0xFF && Bytes[11] == 0xFF) {
+      std::memcpy(Out, Upper ? "::FFFF:" : "::ffff:", 7);
+      std::uint32_t Addr = 0;
+      for (int Ix = 12; Ix < 16; ++Ix)
+        Addr = (Addr << 8) | Bytes[Ix];
+      return writeIPv4(Out + 7, Addr);
+    }
+
+    const char* Digits = Upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    // Single zero groups aren't compressed.
+    const int RunLen = (zeroRunLUT.Size[Mask] > 1) ? zeroRunLUT.Size[Mask] : 0;
+    const int RunStart = RunLen ? zeroRunLUT.Start[Mask] : 8;
+    for (int Ix = 0; Ix < 8; ++Ix) {
+      if (Ix == RunStart) {
+        // The leading colon is only written at the start.
+        if (Ix == 0)
+          *Out++ = ':';
+        *Out++ = ':';
+        Ix += RunLen - 1;
+        continue;
+      }
+      const unsigned Group = (unsigned(Bytes[Ix * 2]) << 8) | Bytes[Ix * 2 + 1];
+      Out = writeIPv6Group(Out, Group, Digits);
+      if (Ix != 7)
+        *Out++ = ':';
+    }
+    return Out;
+  }
+} // namespace `anonymous`
+
+namespace sfmt {
+
+void format_custom(const Formatter& Fmt, const IPv4Addr& Addr) {
+  SmallBufBase& Buf = *Fmt.operator->();
+  // `255.255.255.255` and a byte of slack.
+  Buf.reserveBack(16);
+  char* Begin = Buf.end();
+  char* End = writeIPv4(Begin, Addr.Value);
+  Buf.resizeBack(std::size_t(End - Begin));
+}
+
+void format_custom(const Formatter& Fmt, const IPv6Addr& Addr) {
+  SmallBufBase& Buf = *Fmt.operator->();
+  const bool Upper = 
+    (Fmt.getLastReplacement().Extra == ExtraType::Uppercase);
+  // 8 groups of 4 digits with 7 colons, or 22 for IPv4 mapped.
+  Buf.reserveBack(40);
+  char* Begin = Buf.end();
+  char* End = writeIPv6(Begin, Addr.Bytes, Upper);
+  Buf.resizeBack(std::size_t(End - Begin));
+}
+
+void format_custom(const Formatter& Fmt, const MacAddr& Addr) {
+  SmallBufBase& Buf = *Fmt.operator->();
+  const bool Upper = 
+    (Fmt.getLastReplacement().Extra == ExtraType::Uppercase);
+  Buf.resizeBack(17);
+  char* Out = Buf.end() - 17;
+  // Pad to 8 bytes so the vector path is used, the
+  // extra digits are overwritten below.
+  std::uint8_t Bytes[8] {};
+  std::memcpy(Bytes, Addr.Bytes, 6);
+  hexExpand(Out, Bytes, 8, Upper);
+  // Spread the digit pairs out in place, from the back.
+  for (int Ix = 5; Ix > 0; --Ix) {
+    Out[Ix * 3 + 1] = Out[Ix * 2 + 1];
+    Out[Ix * 3]     = Out[Ix * 2];
+    Out[Ix * 3 - 1] = ':';
+  }
+}
+
+//=== Hex ===//
+
+void format_custom(const Formatter& Fmt, const UuidValue& Uuid) {
+  SmallBufBase& Buf = *Fmt.operator->();
+  const bool Upper = 
+    (Fmt.getLastReplacement().Extra == ExtraType::Uppercase);
+  Buf.resizeBack(36);
+  char* Out = Buf.end() - 36;
+  // Expand 4 digits in, so the last group is already in place.
+  hexExpand(Out + 4, Uuid.Bytes, 16, Upper);
+  // Then move the other groups down over the gaps.
+  std::memmove(Out, Out + 4, 8);
+  Out[8] = '-';
+  std::memmove(Out + 9, Out + 12, 4);
+  Out[13] = '-';
+  std::memmove(Out + 14, Out + 16, 4);
+  Out[18] = '-';
+  std::memmove(Out + 19, Out + 20, 4);
+  Out[23] = '-';
+}
+
+void format_custom(const Formatter& Fmt, const HexBytes& Hex) {
+  if SLIMFMT_UNLIKELY(!Hex.Data || Hex.Size == 0)
+    return;
+  SmallBufBase& Buf = *Fmt.operator->();
+  const bool Upper = 
+    (Fmt.getLastReplacement().Extra == ExtraType::Uppercase);
+  Buf.resizeBack(Hex.Size * 2);
+  hexExpand(Buf.end() - Hex.Size * 2, Hex.Data, Hex.Size, Upper);
+}
+
+} // namespace sfmt
+
+//======================================================================//
+// Big Integers
+//======================================================================//
+
+namespace {
+#if defined(__SIZEOF_INT128__)
+  /// The largest divisor used when splitting limbs.
+  static constexpr std::uint64_t bigDivLimit = ~std::uint64_t(0);
+#else
+  // Without 128-bit division, split each limb in half.
+  static constexpr std::uint64_t bigDivLimit = 0xFFFFFFFFULL;
+#endif
+
+  template <typename T> struct IntFormatBase;
+  template <std::size_t Base, typename V>
+  struct IntFormatBase<IntFormat<Base, V>> {
+    static constexpr std::size_t value = Base;
+  };
+
+  /// The largest power of `Base` used as a divisor, and its digit count.
+  template <std::size_t Base>
+  struct BigChunk {
+    static constexpr std::uint64_t getDiv() {
+      std::uint64_t Div = Base;
+      while (Div <= bigDivLimit / Base)
+        Div *= Base;
+      return Div;
+    }
+    static constexpr int getDigits() {
+      int Digits = 1;
+      for (std::uint64_t Div = Base; Div <= bigDivLimit / Base; Div *= Base)
+        ++Digits;
+      return Digits;
+    }
+    static constexpr int getBits() {
+      int Bits = 0;
+      for (std::uint64_t Div = getDiv(); Div > 1; Div >>= 1)
+        ++Bits;
+      return Bits;
+    }
+  public:
+    static constexpr std::uint64_t div = getDiv();
+    static constexpr int digits = getDigits();
+    /// Each division removes at least this many bits.
+    static constexpr int bits = getBits();
+  };
+
+  /// Divides `Limbs` by `Div` in place, dropping leading zero limbs.
+  /// @return The remainder.
+  std::uint64_t divLimbs(std::uint64_t* Limbs,
+   std::size_t& Size, std::uint64_t Div) {
+    std::uint64_t Rem = 0;
+    for (std::size_t Ix = Size; Ix-- > 0;) {
+#if defined(__SIZEOF_INT128__)
+      using U128 = unsigned __int128;
+      const U128 Cur = (U128(Rem) << 64) | Limbs[Ix];
+      Limbs[Ix] = std::uint64_t(Cur / Div);
+      Rem = std::uint64_t(Cur % Div);
+#else
+      const std::uint64_t Hi = (Rem << 32) | (Limbs[Ix] >> 32);
+      const std::uint64_t HiQ = Hi / Div;
+      const std::uint64_t Lo = ((Hi % Div) << 32) | (Limbs[Ix] & 0xFFFFFFFFULL);
+      Limbs[Ix] = (HiQ << 32) | (Lo / Div);
+      Rem = Lo % Div;
+#endif
+    }
+    while (Size && Limbs[Size - 1] == 0)
+      --Size;
+    return Rem;
+  }
+
+  /// Writes limbs in a power of 2 base backwards, ending at `End`.
+  template <std::size_t Base>
+  char* writeBigPow2(char* End, const std::uint64_t* Limbs,
+   std::size_t Size, bool Upper) {
+    using BT = BaseTraits<Base>;
+    constexpr int Shift = int(BT::shiftCount);
+    char* Out = End;
+    if constexpr ((64 % Shift) == 0) {
+      // Digits never cross limbs, so stream each limb.
+      constexpr int LimbDigits = 64 / Shift;
+      for (std::size_t Ix = 0; Ix < Size; ++Ix) {
+        char* LimbEnd = Out;
+        Out = IntFormat<Base>::WriteBackwards(Out, Limbs[Ix], Upper);
+        if (Ix + 1 == Size)
+          break;
+        while (LimbEnd - Out < LimbDigits)
+          *(--Out) = '0';
+      }
+    } else {
+      const char* Digits = Upper 
+        ? "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+        : "0123456789abcdefghijklmnopqrstuvwxyz";
+      const std::size_t Bits = (Size - 1) * 64 
+        + std::size_t(intLog2(Limbs[Size - 1])) + 1;
+      for (std::size_t Pos = 0; Pos < Bits; Pos += Shift) {
+        const std::size_t Ix = Pos / 64, Off = Pos % 64;
+        std::uint64_t V = Limbs[Ix] >> Off;
+        // Take the rest of the digit from the next limb.
+        if (Off + Shift > 64 && Ix + 1 < Size)
+          V |= Limbs[Ix + 1] << (64 - Off);
+        *(--Out) = Digits[V & ((1ULL << Shift) - 1ULL)];
+      }
+    }
+    return Out;
+  }
+
+  /// Writes limbs backwards by repeatedly dividing by a power of
+  /// `Base`, then writing each chunk with the normal kernel.
+  template <std::size_t Base>
+  char* writeBigChunked(char* End, std::uint64_t* Work,
+   std::size_t Size, bool Upper) {
+    using Chunk = BigChunk<Base>;
+    char* Out = End;
+    while (true) {
+      const std::uint64_t Rem = divLimbs(Work, Size, Chunk::div);
+      char* ChunkEnd = Out;
+      Out = IntFormat<Base>::WriteBackwards(Out, Rem, Upper);
+      if (Size == 0)
+        break;
+      while (ChunkEnd - Out < Chunk::digits)
+        *(--Out) = '0';
+    }
+    return Out;
+  }
+} // namespace `anonymous`
+
+namespace sfmt {
+
+void format_custom(const Formatter& Fmt, const BigInt& Int) {
+  SmallBufBase& Buf = *Fmt.operator->();
+  std::size_t Size = Int.Limbs ? Int.Size : 0;
+  while (Size && Int.Limbs[Size - 1] == 0)
+    --Size;
+  if (Size == 0) {
+    Buf.pushBack('0');
+    return;
+  }
+
+  auto& Spec = Fmt.getLastReplacement();
+  const bool Upper = (Spec.Extra == ExtraType::Uppercase);
+  if SLIMFMT_UNLIKELY(RawBaseType(Spec.Base) == 1) {
+    dbgassert(false && "Big integers can't be unary!");
+    return;
+  }
+
+  // Copied for chunking, as the limbs are divided in place.
+  std::uint64_t LocalWork[8];
+  std::unique_ptr<std::uint64_t[]> HeapWork;
+  std::uint64_t* Work = LocalWork;
+
+  // Write backwards into the end of an upper bound, then move down.
+  const std::size_t OldSize = Buf.size();
+  Buf.resizeBack(Size * 64 + 1);
+  char* Begin = Buf.end() - (Size * 64 + 1);
+  char* End = Buf.end();
+  char* Out = baseDispatch(std::uint64_t(Size), Spec.Base,
+  [&] (auto IFmt, std::uint64_t) -> char* {
+    constexpr std::size_t Base = IntFormatBase<decltype(IFmt)>::value;
+    if constexpr (Base == 1) {
+      return nullptr;
+    } else if constexpr (BaseTraits<Base>::isPow2) {
+      return writeBigPow2<Base>(End, Int.Limbs, Size, Upper);
+    } else {
+      if (Size > std::size(LocalWork)) {
+        HeapWork.reset(new std::uint64_t[Size]);
+        Work = HeapWork.get();
+      }
+      std::memcpy(Work, Int.Limbs, Size * sizeof(std::uint64_t));
+      return writeBigChunked<Base>(End, Work, Size, Upper);
+    }
+  });
+  if SLIMFMT_UNLIKELY(!Out) {
+    Buf.tryResize(OldSize);
+    return;
+  }
+  const auto Len = std::size_t(End - Out);
+  std::memmove(Begin, Out, Len);
+  Buf.tryResize(OldSize + Len);
+}
+
+} // namespace sfmt
+
+//======================================================================//
+// API
+//======================================================================//
+
+namespace {
+
+struct NullPrinter : public BasePrinter {
+  void printerRun(
+   StrView Str, SmallBufBase& Buf, 
+   FmtValue::List Values) const override {
+#ifndef NDEBUG
+    Formatter Fmt {Buf, Str};
+    Fmt.parseWith(Values);
+#endif
+  }
+
+  void defaultWrite(SmallBufBase&) const override {}
+};
+
+struct TestPrinter : public NullPrinter {
+  void printerRun(
+   StrView Str, SmallBufBase& Buf, 
+   FmtValue::List Values) const override {
+    Formatter Fmt {Buf, Str};
+    Fmt.parseWith(Values);
+  }
+};
+
+template <bool UseErr, bool AddLine>
+struct OutPrinter : public BasePrinter {
+  void printerRun(
+   StrView Str, SmallBufBase& Buf, 
    FmtValue::List Values) const override {
     Formatter Fmt {Buf, Str};
     Fmt.parseWith(Values);
@@ -1335,12 +3623,23 @@ struct OutPrinter : public BasePrinter {
   }
 };
 
+struct LogfmtPrinter : public BasePrinter {
+  void printerRun(
+   StrView Str, SmallBufBase& Buf, 
+   FmtValue::List Values) const override {
+    Formatter Fmt {Buf, ""};
+    Fmt.logfmtWith(Str, Values);
+    Buf.pushBack('\n');
+  }
+};
+
 static const NullPrinter nullV {};
 static const TestPrinter testV {};
 static const OutPrinter<false, false> outV {};
 static const OutPrinter<true,  false> errV {};
 static const OutPrinter<false, true>  outlnV {};
 static const OutPrinter<true,  true>  errlnV {};
+static const LogfmtPrinter logfmtV {};
 
 } // namespace anonymous
 
@@ -1352,6 +3651,7 @@ constexpr Printer& out     = outV;
 constexpr Printer& err     = errV;
 constexpr Printer& outln   = outlnV;
 constexpr Printer& errln   = errlnV;
+constexpr Printer& logfmt  = logfmtV;
 
 // Aliases
 constexpr Printer& nulls   = null;
@@ -1360,6 +3660,789 @@ constexpr Printer& println = outln;
 
 } // namespace sfmt
 
+namespace {
+  /// `toChars` and `countDigits` only accept bases in `[2, 36]`.
+  inline bool isCharsBase(int Base) {
+    return SLIMFMT_LIKELY(Base >= 2 && Base <= 36);
+  }
+} // namespace `anonymous`
+
+char* sfmt::toChars(char* First, char* Last,
+ unsigned long long Value, int Base, bool Upper) {
+  if SLIMFMT_UNLIKELY(!isCharsBase(Base))
+    return nullptr;
+  const int Len = countDigitsDispatch(std::uint64_t(Value), Base);
+  if SLIMFMT_UNLIKELY(!First || (Last - First) < Len)
+    return nullptr;
+  char* End = First + Len;
+  if (Value == 0) {
+    *First = '0';
+    return End;
+  }
+  baseDispatch(Value, Base,
+  [End, Upper] (auto Fmt, std::uint64_t Value) {
+    return Fmt.WriteBackwards(End, Value, Upper);
+  });
+  return End;
+}
+
+char* sfmt::toChars(char* First, char* Last,
+ long long Value, int Base, bool Upper) {
+  if (Value >= 0)
+    return toChars(First, Last, (unsigned long long)Value, Base, Upper);
+  // Nothing is written on failure, including the sign.
+  if SLIMFMT_UNLIKELY(!isCharsBase(Base) || !First || First == Last)
+    return nullptr;
+  char* End = toChars(First + 1, Last, 
+    (unsigned long long)absValue(Value), Base, Upper);
+  if SLIMFMT_LIKELY(End)
+    *First = '-';
+  return End;
+}
+
+int sfmt::countDigits(long long Value, int Base) {
+  if SLIMFMT_UNLIKELY(!isCharsBase(Base))
+    return -1;
+  return Formatter::CountDigits(Value, Base);
+}
+
+int sfmt::countDigits(unsigned long long Value, int Base) {
+  if SLIMFMT_UNLIKELY(!isCharsBase(Base))
+    return -1;
+  return Formatter::CountDigits(Value, Base);
+}
+
+//=== Log Printers ===//
+
+LogPrinter::LogPrinter(std::FILE* File, const LogConfig& Cfg) {
+  State.Kind = SinkKind::File;
+  State.Sink = File;
+  this->init(Cfg);
+}
+
+LogPrinter::LogPrinter(std::ostream& Stream, const LogConfig& Cfg) {
+  State.Kind = SinkKind::Stream;
+  State.Sink = &Stream;
+  this->init(Cfg);
+}
+
+LogPrinter::LogPrinter(SinkFunc Func, void* Data, const LogConfig& Cfg) {
+  dbgassert(Func && "Sink function cannot be null!");
+  State.Kind = SinkKind::Func;
+  State.Sink = Data;
+  State.Func = Func;
+  this->init(Cfg);
+}
+
+void LogPrinter::init(const LogConfig& Cfg) {
+  State.Level.store(Cfg.Level, std::memory_order_relaxed);
+  State.Color.store(Cfg.Color, std::memory_order_relaxed);
+  State.FlushEach = Cfg.FlushEach;
+  State.AddLine = Cfg.AddLine;
+  if SLIMFMT_UNLIKELY(Cfg.Prefix.size() > maxPrefix) {
+    reportError(FmtError::InvalidArgument, Cfg.Prefix);
+    dbgassert(false && "Prefix will be truncated!");
+  }
+  const std::size_t Len = std::min(Cfg.Prefix.size(), maxPrefix);
+  if (Len != 0)
+    std::memcpy(State.Prefix, Cfg.Prefix.data(), Len);
+  State.PrefixSize = std::uint8_t(Len);
+  for (std::size_t Ix = 0; Ix < std::size(Levels); ++Ix) {
+    Levels[Ix].Parent = this;
+    Levels[Ix].Level = LogLevel(Ix);
+  }
+}
+
+const BasePrinter& LogPrinter::at(LogLevel Level) const {
+  if SLIMFMT_UNLIKELY(Level >= LogLevel::Off) {
+    dbgassert(false && "Invalid log level!");
+    Level = LogLevel::Error;
+  }
+  return Levels[std::size_t(Level)];
+}
+
+void LogPrinter::run(LogLevel Level, StrView Str,
+ SmallBufBase& Buf, FmtValue::List Values) const {
+  if (!this->isEnabled(Level))
+    return;
+  // Colors are part of the message, so sinks get a single write.
+  const char* Color = nullptr;
+  if (State.Color.load(std::memory_order_relaxed)) {
+    if (Level == LogLevel::Warn)
+      Color = "\e[0;33m";
+    else if (Level == LogLevel::Error)
+      Color = "\e[0;31m";
+  }
+  if (Color)
+    Buf.append(Color, std::strlen(Color));
+  Buf.append(State.Prefix, State.PrefixSize);
+  Formatter Fmt {Buf, Str};
+  Fmt.parseWith(Values);
+  if (Color)
+    Buf.append("\e[0m", 4);
+  if (State.AddLine)
+    Buf.pushBack('\n');
+}
+
+void LogPrinter::write(SmallBufBase& Buf) const {
+  if SLIMFMT_UNLIKELY(Buf.isEmpty())
+    return;
+  switch (State.Kind) {
+    case SinkKind::File: {
+      auto* File = static_cast<std::FILE*>(State.Sink);
+      Buf.writeTo(File);
+      if (State.FlushEach)
+        std::fflush(File);
+      break;
+    }
+    case SinkKind::Stream: {
+      auto* Stream = static_cast<std::ostream*>(State.Sink);
+      Buf.writeTo(*Stream);
+      if (State.FlushEach)
+        Stream->flush();
+      break;
+    }
+    case SinkKind::Func:
+      State.Func(State.Sink, StrView(Buf.data(), Buf.size()));
+      break;
+  }
+}
+
+void LogPrinter::printerRun(StrView Str,
+ SmallBufBase& Buf, FmtValue::List Values) const {
+  this->run(LogLevel::Info, Str, Buf, Values);
+}
+
+void LogPrinter::defaultWrite(SmallBufBase& Buf) const {
+  this->write(Buf);
+}
+
+void LogPrinter::LevelPrinter::printerRun(StrView Str,
+ SmallBufBase& Buf, FmtValue::List Values) const {
+  Parent->run(this->Level, Str, Buf, Values);
+}
+
+void LogPrinter::LevelPrinter::defaultWrite(SmallBufBase& Buf) const {
+  Parent->write(Buf);
+}
+
+//=== Log Modules ===//
+
+namespace {
+  /// Constant initialized, like `precompiledHead`.
+  static std::atomic<LogModule*> logModuleHead {nullptr};
+} // namespace `anonymous`
+
+LogModule::LogModule(const char* Name, std::uint64_t Mask) :
+ Mask(Mask), Name(Name) {
+  LogModule* Head = logModuleHead.load(std::memory_order_relaxed);
+  do {
+    this->Next = Head;
+  } while (!logModuleHead.compare_exchange_weak(
+    Head, this, std::memory_order_release, std::memory_order_relaxed));
+}
+
+void LogModule::setPrinter(const BasePrinter& Out) {
+  for (auto& Printer : Printers)
+    Printer.store(&Out, std::memory_order_relaxed);
+}
+
+void LogModule::setPrinter(const LogPrinter& Out) {
+  for (std::size_t Ix = 0; Ix < std::size(Printers); ++Ix)
+    Printers[Ix].store(&Out.at(LogLevel(Ix)), std::memory_order_relaxed);
+}
+
+const BasePrinter* LogModule::getPrinter(LogLevel Level) const {
+  if SLIMFMT_UNLIKELY(Level >= LogLevel::Off) {
+    dbgassert(false && "Invalid log level!");
+    Level = LogLevel::Error;
+  }
+  const BasePrinter* Out = 
+    Printers[std::size_t(Level)].load(std::memory_order_relaxed);
+  return Out ? Out : &errln;
+}
+
+LogModule* sfmt::getLogModules() {
+  return logModuleHead.load(std::memory_order_acquire);
+}
+
+LogModule* sfmt::findLogModule(StrView Name) {
+  for (LogModule* Mod = getLogModules(); Mod; Mod = Mod->getNext()) {
+    if (Name == Mod->getName())
+      return Mod;
+  }
+  return nullptr;
+}
+
+//=== Call Sites ===//
+
+#if SLIMFMT_HAS_CALL_SITES
+// Defined by the linker for sections with C identifier names.
+// Weak, as the section won't exist without any call sites.
+extern "C" {
+  extern CallSite __start_slimfmt_sites[] __attribute__((weak));
+  extern CallSite __stop_slimfmt_sites[] __attribute__((weak));
+}
+#endif // SLIMFMT_HAS_CALL_SITES
+
+namespace {
+  struct DebugQuery {
+    StrView File, Module, Format;
+    std::uint32_t LineLo = 0;
+    std::uint32_t LineHi = ~std::uint32_t(0);
+    bool Enable = false;
+  public:
+    bool matches(const CallSite& Site) const {
+      if (!Module.empty() && Module != Site.Module)
+        return false;
+      if (Site.Line < LineLo || Site.Line > LineHi)
+        return false;
+      const StrView SiteFile {Site.File};
+      if (!File.empty() && (SiteFile.size() < File.size() ||
+       SiteFile.substr(SiteFile.size() - File.size()) != File))
+        return false;
+      return Format.empty() ||
+        StrView(Site.Format).find(Format) != StrView::npos;
+    }
+  };
+
+  static StrView nextToken(StrView& Str) {
+    const std::size_t Begin = Str.find_first_not_of(" \t\r\n");
+    if (Begin == StrView::npos) {
+      Str = StrView();
+      return StrView();
+    }
+    Str.remove_prefix(Begin);
+    const std::size_t End = std::min(Str.find_first_of(" \t\r\n"), Str.size());
+    const StrView Token = Str.substr(0, End);
+    Str.remove_prefix(End);
+    return Token;
+  }
+
+  static bool parseLine(StrView Str, std::uint32_t& Out) {
+    std::size_t Value = 0;
+    const char* End = Str.data() + Str.size();
+    if (Str.empty() || parseSpecInt(Str.data(), End, Value) != End)
+      return false;
+    if (Value > UINT32_MAX)
+      return false;
+    Out = std::uint32_t(Value);
+    return true;
+  }
+
+  /// Parses `[keyword value]... (+p|-p)`.
+  static bool parseDebugQuery(StrView Command, DebugQuery& Query) {
+    bool HasAction = false;
+    while (true) {
+      const StrView Key = nextToken(Command);
+      if (Key.empty())
+        return HasAction;
+      if (HasAction)
+        return false;
+      if (Key == "+p" || Key == "-p") {
+        Query.Enable = (Key[0] == '+');
+        HasAction = true;
+        continue;
+      }
+      const StrView Value = nextToken(Command);
+      if (Value.empty())
+        return false;
+      if (Key == "file") {
+        Query.File = (Value == "*") ? StrView() : Value;
+      } else if (Key == "module") {
+        Query.Module = (Value == "*") ? StrView() : Value;
+      } else if (Key == "format") {
+        Query.Format = Value;
+      } else if (Key == "line") {
+        const std::size_t Dash = Value.find('-');
+        if (!parseLine(Value.substr(0, Dash), Query.LineLo))
+          return false;
+        Query.LineHi = Query.LineLo;
+        if (Dash != StrView::npos &&
+         !parseLine(Value.substr(Dash + 1), Query.LineHi))
+          return false;
+      } else {
+        return false;
+      }
+    }
+  }
+} // namespace `anonymous`
+
+CallSiteRange sfmt::getCallSites() {
+#if SLIMFMT_HAS_CALL_SITES
+  return {__start_slimfmt_sites, __stop_slimfmt_sites};
+#else
+  return {};
+#endif
+}
+
+std::size_t sfmt::applyDebugControl(StrView Command) {
+  DebugQuery Query;
+  if (!parseDebugQuery(Command, Query))
+    return 0;
+  std::size_t Count = 0;
+  for (CallSite& Site : getCallSites()) {
+    if (!Query.matches(Site))
+      continue;
+    Site.Enabled.store(Query.Enable, std::memory_order_relaxed);
+    ++Count;
+  }
+  return Count;
+}
+
+long sfmt::loadDebugControl(const char* Path) {
+  std::FILE* File = std::fopen(Path, "r");
+  if (!File)
+    return -1;
+  long Count = 0;
+  char Line[512];
+  while (std::fgets(Line, sizeof(Line), File)) {
+    StrView Command {Line};
+    Command = Command.substr(0, Command.find('#'));
+    Count += long(applyDebugControl(Command));
+  }
+  std::fclose(File);
+  return Count;
+}
+
+#if SLIMFMT_HAS_SIGNALS
+namespace {
+  /// Written to by the signal handler, and read by the watcher.
+  static int controlPipe[2] {-1, -1};
+
+  static void onControlSignal(int) {
+    const int OldErrno = errno;
+    [[maybe_unused]] auto Ret = ::write(controlPipe[1], "", 1);
+    errno = OldErrno;
+  }
+} // namespace `anonymous`
+#endif // SLIMFMT_HAS_SIGNALS
+
+bool sfmt::watchDebugControl(const char* Path, int Signal) {
+#if SLIMFMT_HAS_SIGNALS
+  static std::atomic<bool> Watching {false};
+  if (!Path || Watching.exchange(true))
+    return false;
+  auto Fail = [] {
+    ::close(controlPipe[0]);
+    ::close(controlPipe[1]);
+    controlPipe[0] = controlPipe[1] = -1;
+    Watching.store(false);
+    return false;
+  };
+  // Not inherited by children. A full pipe already means a reload
+  // is pending, so the handler never blocks.
+  if (::pipe2(controlPipe, O_CLOEXEC) != 0) {
+    Watching.store(false);
+    return false;
+  }
+  if (::fcntl(controlPipe[1], F_SETFL, O_NONBLOCK) != 0)
+    return Fail();
+
+  struct sigaction Action {};
+  Action.sa_handler = &onControlSignal;
+  Action.sa_flags = SA_RESTART;
+  sigemptyset(&Action.sa_mask);
+  if (::sigaction(Signal, &Action, nullptr) != 0)
+    return Fail();
+
+  std::thread([Path = std::string(Path)] {
+    char Buf[64];
+    while (true) {
+      const auto Len = ::read(controlPipe[0], Buf, sizeof(Buf));
+      if (Len < 0 && errno == EINTR)
+        continue;
+      if (Len <= 0)
+        return;
+      (void) loadDebugControl(Path.c_str());
+    }
+  }).detach();
+  return true;
+#else
+  (void) Path;
+  (void) Signal;
+  return false;
+#endif // SLIMFMT_HAS_SIGNALS
+}
+
+//=== Shared Memory Rings ===//
+
+/// The start of the mapping. Positions only ever increase, and each
+/// slot's sequence says who may touch it: `Pos` when free for the
+/// writer claiming `Pos`, and `Pos + 1` once readable.
+struct ShmRing::Header {
+  static constexpr std::uint32_t magic = 0x52464D53; // "SMFR"
+  static constexpr std::uint32_t version = 1;
+public:
+  std::atomic<std::uint32_t> Magic;
+  std::uint32_t Version;
+  std::uint32_t SlotCount;
+  std::uint32_t SlotSize;
+  // Written by producers.
+  alignas(64) std::atomic<std::uint64_t> WritePos;
+  std::atomic<std::uint64_t> Dropped;
+  // Written by the reader.
+  alignas(64) std::atomic<std::uint64_t> ReadPos;
+  std::atomic<std::uint64_t> Wakeups;
+  std::atomic<std::uint32_t> Waiting;
+  std::atomic<std::uint32_t> Futex;
+};
+
+struct ShmRing::Slot {
+  std::atomic<std::uint64_t> Seq;
+  std::uint32_t Size;
+  std::uint32_t Reserved;
+public:
+  char* data() { return reinterpret_cast<char*>(this + 1); }
+};
+
+namespace {
+  static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+    "Shared atomics must be address free.");
+
+  constexpr std::size_t shmHeaderSize = 256;
+
+  constexpr bool isValidRingSize(std::uint64_t SlotCount,
+   std::uint64_t SlotSize) {
+    return SlotCount >= 2 && SlotCount <= (1U << 24)
+      && SlotSize >= 64 && SlotSize <= (1U << 20)
+      && (SlotCount & (SlotCount - 1)) == 0
+      && (SlotSize & (SlotSize - 1)) == 0;
+  }
+
+#if SLIMFMT_HAS_SHM_RING
+  long futexCall(std::atomic<std::uint32_t>& Word, int Op,
+   std::uint32_t Value, const timespec* Timeout = nullptr) {
+    // Not `_PRIVATE`, as the word is shared between processes.
+    return ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&Word),
+      Op, Value, Timeout, nullptr, 0);
+  }
+#endif // SLIMFMT_HAS_SHM_RING
+} // namespace `anonymous`
+
+ShmRing::ShmRing(ShmRing&& Other) noexcept :
+ Hdr(Other.Hdr), MapSize(Other.MapSize), Fd(Other.Fd) {
+  Other.Hdr = nullptr;
+  Other.MapSize = 0;
+  Other.Fd = -1;
+}
+
+ShmRing& ShmRing::operator=(ShmRing&& Other) noexcept {
+  if SLIMFMT_LIKELY(this != &Other) {
+    this->reset();
+    std::swap(Hdr, Other.Hdr);
+    std::swap(MapSize, Other.MapSize);
+    std::swap(Fd, Other.Fd);
+  }
+  return *this;
+}
+
+ShmRing::~ShmRing() {
+  this->reset();
+}
+
+void ShmRing::reset() {
+#if SLIMFMT_HAS_SHM_RING
+  if (Hdr)
+    ::munmap(Hdr, MapSize);
+  if (Fd >= 0)
+    ::close(Fd);
+#endif // SLIMFMT_HAS_SHM_RING
+  Hdr = nullptr;
+  MapSize = 0;
+  Fd = -1;
+}
+
+ShmRing ShmRing::create(const char* Name,
+ std::uint32_t SlotCount, std::uint32_t SlotSize) {
+  static_assert(sizeof(Header) <= shmHeaderSize);
+#if SLIMFMT_HAS_SHM_RING
+  if (!Name || !isValidRingSize(SlotCount, SlotSize))
+    return {};
+  const int Fd = (Name[0] == '/')
+    ? ::shm_open(Name, O_RDWR | O_CREAT | O_TRUNC, 0600)
+    : ::memfd_create(Name, MFD_CLOEXEC);
+  if (Fd < 0)
+    return {};
+  const std::size_t Size = shmHeaderSize + std::size_t(SlotCount) * SlotSize;
+  if (::ftruncate(Fd, off_t(Size)) != 0) {
+    ::close(Fd);
+    return {};
+  }
+  // The file is zeroed, so only nonzero fields are set.
+  ShmRing Ring = ShmRing::map(Fd, Size);
+  if (!Ring) {
+    ::close(Fd);
+    return {};
+  }
+  Header* Hdr = Ring.Hdr;
+  Hdr->SlotCount = SlotCount;
+  Hdr->SlotSize = SlotSize;
+  for (std::uint32_t Ix = 0; Ix < SlotCount; ++Ix)
+    Ring.getSlot(Ix)->Seq.store(Ix, std::memory_order_relaxed);
+  Hdr->Version = Header::version;
+  // Publishes the fields above to `attach`.
+  Hdr->Magic.store(Header::magic, std::memory_order_release);
+  return Ring;
+#else
+  (void) Name;
+  (void) SlotCount;
+  (void) SlotSize;
+  return {};
+#endif // SLIMFMT_HAS_SHM_RING
+}
+
+ShmRing ShmRing::map(int Fd, std::size_t Size) {
+#if SLIMFMT_HAS_SHM_RING
+  void* Ptr = ::mmap(nullptr, Size,
+    PROT_READ | PROT_WRITE, MAP_SHARED, Fd, 0);
+  if (Ptr == MAP_FAILED)
+    return {};
+  return ShmRing(Fd, static_cast<Header*>(Ptr), Size);
+#else
+  (void) Fd;
+  (void) Size;
+  return {};
+#endif // SLIMFMT_HAS_SHM_RING
+}
+
+ShmRing ShmRing::attach(int Fd) {
+#if SLIMFMT_HAS_SHM_RING
+  struct stat Info;
+  if (Fd < 0 || ::fstat(Fd, &Info) != 0 ||
+   std::size_t(Info.st_size) < shmHeaderSize)
+    return {};
+  const std::size_t Size = std::size_t(Info.st_size);
+  ShmRing Ring = ShmRing::map(Fd, Size);
+  if (!Ring)
+    return {};
+  // Rings still being created are rejected too.
+  const Header* Hdr = Ring.Hdr;
+  if (Hdr->Magic.load(std::memory_order_acquire) != Header::magic ||
+   Hdr->Version != Header::version ||
+   !isValidRingSize(Hdr->SlotCount, Hdr->SlotSize) ||
+   Size != shmHeaderSize + std::size_t(Hdr->SlotCount) * Hdr->SlotSize) {
+    // The caller keeps the descriptor.
+    Ring.Fd = -1;
+    return {};
+  }
+  return Ring;
+#else
+  (void) Fd;
+  return {};
+#endif // SLIMFMT_HAS_SHM_RING
+}
+
+ShmRing ShmRing::attach(const char* Name) {
+#if SLIMFMT_HAS_SHM_RING
+  if (!Name || Name[0] != '/')
+    return {};
+  const int Fd = ::shm_open(Name, O_RDWR, 0);
+  ShmRing Ring = ShmRing::attach(Fd);
+  if (!Ring && Fd >= 0)
+    ::close(Fd);
+  return Ring;
+#else
+  (void) Name;
+  return {};
+#endif // SLIMFMT_HAS_SHM_RING
+}
+
+std::size_t ShmRing::getSlotCount() const {
+  return Hdr ? Hdr->SlotCount : 0;
+}
+
+std::size_t ShmRing::getMaxMessage() const {
+  return Hdr ? (Hdr->SlotSize - sizeof(Slot)) : 0;
+}
+
+ShmRing::Stats ShmRing::getStats() const {
+  Stats Out;
+  if SLIMFMT_UNLIKELY(!Hdr)
+    return Out;
+  Out.Written = Hdr->WritePos.load(std::memory_order_relaxed);
+  Out.Dropped = Hdr->Dropped.load(std::memory_order_relaxed);
+  Out.Wakeups = Hdr->Wakeups.load(std::memory_order_relaxed);
+  return Out;
+}
+
+ShmRing::Slot* ShmRing::getSlot(std::uint64_t Pos) const {
+  const std::uint64_t Ix = Pos & (Hdr->SlotCount - 1);
+  char* const Base = reinterpret_cast<char*>(Hdr) + shmHeaderSize;
+  return reinterpret_cast<Slot*>(Base + Ix * Hdr->SlotSize);
+}
+
+bool ShmRing::write(StrView Message) {
+#if SLIMFMT_HAS_SHM_RING
+  if SLIMFMT_UNLIKELY(!Hdr)
+    return false;
+  std::uint64_t Pos = Hdr->WritePos.load(std::memory_order_relaxed);
+  Slot* S;
+  while (true) {
+    S = this->getSlot(Pos);
+    const std::uint64_t Seq = S->Seq.load(std::memory_order_acquire);
+    const auto Diff = std::int64_t(Seq - Pos);
+    if SLIMFMT_LIKELY(Diff == 0) {
+      if (Hdr->WritePos.compare_exchange_weak(Pos, Pos + 1,
+       std::memory_order_relaxed))
+        break;
+    } else if (Diff < 0) {
+      // The reader hasn't freed this slot yet.
+      Hdr->Dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    } else {
+      Pos = Hdr->WritePos.load(std::memory_order_relaxed);
+    }
+  }
+
+  const std::size_t Size = std::min(Message.size(), this->getMaxMessage());
+  std::memcpy(S->data(), Message.data(), Size);
+  S->Size = std::uint32_t(Size);
+  S->Seq.store(Pos + 1, std::memory_order_release);
+
+  // Pairs with the fence in `read`, so either the reader sees
+  // the message, or we see that it's waiting.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if SLIMFMT_UNLIKELY(Hdr->Waiting.load(std::memory_order_relaxed) &&
+   Hdr->Waiting.exchange(0, std::memory_order_relaxed)) {
+    Hdr->Futex.fetch_add(1, std::memory_order_release);
+    Hdr->Wakeups.fetch_add(1, std::memory_order_relaxed);
+    (void) futexCall(Hdr->Futex, FUTEX_WAKE, 1);
+  }
+  return true;
+#else
+  (void) Message;
+  return false;
+#endif // SLIMFMT_HAS_SHM_RING
+}
+
+bool ShmRing::read(std::string& Out, int TimeoutMs) {
+#if SLIMFMT_HAS_SHM_RING
+  using Clock = std::chrono::steady_clock;
+  if SLIMFMT_UNLIKELY(!Hdr)
+    return false;
+  const std::uint64_t Pos = Hdr->ReadPos.load(std::memory_order_relaxed);
+  Slot* const S = this->getSlot(Pos);
+  const auto Deadline = Clock::now() + std::chrono::milliseconds(TimeoutMs);
+
+  while (S->Seq.load(std::memory_order_acquire) != Pos + 1) {
+    if (TimeoutMs == 0)
+      return false;
+    const std::uint32_t Word = Hdr->Futex.load(std::memory_order_acquire);
+    Hdr->Waiting.store(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (S->Seq.load(std::memory_order_acquire) == Pos + 1)
+      break;
+    timespec Timeout {};
+    if (TimeoutMs > 0) {
+      const auto Left = Deadline - Clock::now();
+      if (Left <= Clock::duration::zero())
+        break;
+      const auto Nanos =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Left).count();
+      Timeout.tv_sec = time_t(Nanos / 1000000000);
+      Timeout.tv_nsec = long(Nanos % 1000000000);
+    }
+    (void) futexCall(Hdr->Futex, FUTEX_WAIT,
+      Word, (TimeoutMs > 0) ? &Timeout : nullptr);
+  }
+  Hdr->Waiting.store(0, std::memory_order_relaxed);
+  if (S->Seq.load(std::memory_order_acquire) != Pos + 1)
+    return false;
+
+  Out.assign(S->data(), S->Size);
+  // Frees the slot for the writer one lap ahead.
+  S->Seq.store(Pos + Hdr->SlotCount, std::memory_order_release);
+  Hdr->ReadPos.store(Pos + 1, std::memory_order_relaxed);
+  return true;
+#else
+  (void) Out;
+  (void) TimeoutMs;
+  return false;
+#endif // SLIMFMT_HAS_SHM_RING
+}
+
+const char* sfmt::getErrorMessage(FmtError Error) {
+  switch (Error) {
+    case FmtError::InvalidSpec:      return "Invalid format specifier";
+    case FmtError::InvalidWidth:     return "Invalid width specifier";
+    case FmtError::InvalidBase:      return "Base out of range";
+    case FmtError::InvalidPrecision: return "Invalid precision";
+    case FmtError::Unterminated:     return "Unterminated format specifier";
+    case FmtError::MissingArgument:  return "Not enough arguments";
+    case FmtError::ExtraArgument:    return "Too many arguments";
+    case FmtError::InvalidArgument:  return "Invalid argument type";
+  }
+  return "Unknown error";
+}
+
+void sfmt::stderrErrorHandler(FmtError Error, StrView Spec) {
+  static std::atomic<unsigned> Reported {0};
+  constexpr unsigned MaxReports = 16;
+  const unsigned Ix = Reported.fetch_add(1, std::memory_order_relaxed);
+  if (Ix >= MaxReports)
+    return;
+  // Writes pieces directly, as `Spec` isn't null terminated.
+  const char* Message = getErrorMessage(Error);
+  std::fputs("slimfmt: ", stderr);
+  std::fputs(Message, stderr);
+  if (!Spec.empty()) {
+    std::fputs(" in `", stderr);
+    std::fwrite(Spec.data(), 1, Spec.size(), stderr);
+    std::fputc('`', stderr);
+  }
+  if (Ix + 1 == MaxReports)
+    std::fputs(" (further errors are not shown)", stderr);
+  std::fputc('\n', stderr);
+}
+
+HugePageStats sfmt::getHugePageStats() {
+  HugePageStats Stats;
+  Stats.Mapped   = hugePageCounters.Mapped.load(std::memory_order_relaxed);
+  Stats.Explicit = hugePageCounters.Explicit.load(std::memory_order_relaxed);
+  Stats.Advised  = hugePageCounters.Advised.load(std::memory_order_relaxed);
+  Stats.Remapped = hugePageCounters.Remapped.load(std::memory_order_relaxed);
+  return Stats;
+}
+
+bool sfmt::hasHugePages(const void* Ptr) {
+#if SLIMFMT_HUGE_PAGES
+  std::FILE* File = std::fopen("/proc/self/smaps", "r");
+  if (!File)
+    return false;
+  const auto Addr = reinterpret_cast<std::uintptr_t>(Ptr);
+  bool InRange = false, Found = false, AtStart = true;
+  char Line[256];
+  while (!Found && std::fgets(Line, sizeof(Line), File)) {
+    // Skip the rest of lines longer than the buffer.
+    const bool WasAtStart = AtStart;
+    AtStart = (std::strchr(Line, '\n') != nullptr);
+    if (!WasAtStart)
+      continue;
+    // Mappings start with `lo-hi`, and fields with `Name:`.
+    char* End = nullptr;
+    const auto Lo = std::uintptr_t(std::strtoull(Line, &End, 16));
+    if (End != Line && *End == '-') {
+      const auto Hi = std::uintptr_t(std::strtoull(End + 1, nullptr, 16));
+      InRange = (Addr >= Lo && Addr < Hi);
+      continue;
+    }
+    if (!InRange)
+      continue;
+    const StrView Field {Line};
+    if (Field.rfind("AnonHugePages:", 0) == 0)
+      Found = std::strtoull(Line + 14, nullptr, 10) != 0;
+    else if (Field.rfind("KernelPageSize:", 0) == 0)
+      Found = std::strtoull(Line + 15, nullptr, 10) > 4;
+  }
+  std::fclose(File);
+  return Found;
+#else
+  (void) Ptr;
+  return false;
+#endif // SLIMFMT_HUGE_PAGES
+}
+
 void sfmt::flush(std::FILE* File) {
   std::fflush(File);
 }
@@ -21,6 +21,7 @@
 #ifndef SLIMFMT_HSLIMFMT_HPP
 #define SLIMFMT_HSLIMFMT_HPP
 
+#include <atomic>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
@@ -39,6 +40,22 @@
 # define SLIMFMT_STDERR_ASSERT 0
 #endif
 
+#ifndef SLIMFMT_VALIDATE
+# define SLIMFMT_VALIDATE 0
+#endif
+
+/// `SLIMFMT_LOG` calls below this level (see `LogLevel`) are removed
+/// at compile time. For example, 2 only keeps `Info` and above.
+#ifndef SLIMFMT_LOG_FLOOR
+# define SLIMFMT_LOG_FLOOR 0
+#endif
+
+/// Buffers of at least this many bytes are mapped directly,
+/// and backed by huge pages when possible. Use 0 to disable.
+#ifndef SLIMFMT_HUGE_PAGE_THRESHOLD
+# define SLIMFMT_HUGE_PAGE_THRESHOLD (32ULL << 20)
+#endif
+
 #ifdef __has_cpp_attribute
 # define SLIMFMT_HAS_CPP_ATTR(x) (__has_cpp_attribute(x))
 #else
@@ -235,9 +252,10 @@ public:
   }
 
 protected:
-  static char* AllocateBuffer(size_type Cap) {
-    return new char[Cap];
-  }
+  /// Buffers at or above `SLIMFMT_HUGE_PAGE_THRESHOLD` are mapped,
+  /// so both functions need the capacity.
+  static char* AllocateBuffer(size_type Cap);
+  static void DeallocateBuffer(char* Ptr, size_type Cap);
 
   /// Sets the new buffer pointer and cap.
   /// @return The old buffer pointer.
@@ -248,7 +266,7 @@ protected:
   void tweakCapacity();
 
   void deallocate() {
-    delete[] this->Data;
+    DeallocateBuffer(this->Data, this->Capacity);
   }
 
   void resetSize() {
@@ -283,8 +301,6 @@ public:
 protected:
   SmallBufImpl(size_type Cap) :
    DynBuf(Cap ? getFirstElem() : nullptr, Cap) {}
-  
-  SmallBufImpl(SmallBufImpl&& Other);
 
 public:
   void writeTo(std::basic_ostream<char>& OS);
@@ -403,6 +419,59 @@ protected:
   }
 };
 
+/// A local write position in a `SmallBufImpl`. Writes through the
+/// cursor don't update the buffer, so `char` stores can't force its
+/// size to be reloaded. The size is only written back when growing,
+/// or when `commit` is called.
+class BufCursor {
+public:
+  explicit BufCursor(SmallBufImpl& Buf) : Buf(Buf) {
+    this->reload();
+  }
+  BufCursor(const BufCursor&) = delete;
+  BufCursor& operator=(const BufCursor&) = delete;
+  ~BufCursor() { this->commit(); }
+
+public:
+  /// @return A pointer where at least `N` chars can be written.
+  char* reserve(std::size_t N) {
+    if SLIMFMT_LIKELY(std::size_t(Lim - Ptr) >= N)
+      return Ptr;
+    return this->grow(N);
+  }
+
+  void advance(std::size_t N) {
+    this->Ptr += N;
+  }
+
+  void append(const char* Str, std::size_t N) {
+    if SLIMFMT_UNLIKELY(N == 0)
+      return;
+    char* Out = this->reserve(N);
+    std::memcpy(Out, Str, N);
+    this->Ptr = Out + N;
+  }
+
+  /// Writes the size back to the buffer.
+  void commit() {
+    Buf.tryResize(std::size_t(Ptr - Buf.begin()));
+  }
+
+  /// Picks up changes made to the buffer directly.
+  void reload() {
+    this->Ptr = Buf.end();
+    this->Lim = Buf.begin() + Buf.capacity();
+  }
+
+private:
+  char* grow(std::size_t N);
+
+private:
+  SmallBufImpl& Buf;
+  char* Ptr = nullptr;
+  char* Lim = nullptr;
+};
+
 /// The underlying storage for `SmallBuf`.
 template <std::size_t Size>
 struct SmallBufStorage {
@@ -457,12 +526,21 @@ public:
     this->move(Other);
   }
 
+  SmallBuf(SmallBuf&& Other) :
+   H::SmallBufImpl(InlinedSize) {
+    this->move(Other);
+  }
+
   SmallBuf& operator=(BaseType&& Other) {
     assert(!isReferenceToSelf(Other) && "Moved into self!");
     this->move(Other);
     return *this;
   }
 
+  SmallBuf& operator=(SmallBuf&& Other) {
+    return *this = static_cast<BaseType&&>(Other);
+  }
+
   ~SmallBuf() { this->deallocateIfDynamicFast(); }
 
 public:
@@ -505,15 +583,6 @@ namespace sfmt {
 struct Formatter;
 
 namespace H {
-  template <typename T>
-  inline constexpr bool isBuiltinType =
-    std::is_arithmetic_v<T>         ||
-    std::is_enum_v<T>               ||
-    std::is_null_pointer_v<T>       ||
-    std::is_same_v<T, const char*>  ||
-    std::is_same_v<T, std::string>  ||
-    std::is_same_v<T, StrView>;
-
   template <typename T, typename = void>
   struct HasAnyFmt : std::false_type {};
 
@@ -526,6 +595,16 @@ namespace H {
   
   template <typename T>
   inline constexpr bool hasAnyFmt = HasAnyFmt<T>::value;
+
+  /// Enums with a format overload (eg. `SLIMFMT_ENUM`) aren't builtin.
+  template <typename T>
+  inline constexpr bool isBuiltinType =
+    std::is_arithmetic_v<T>         ||
+    (std::is_enum_v<T> && !hasAnyFmt<T>) ||
+    std::is_null_pointer_v<T>       ||
+    std::is_same_v<T, const char*>  ||
+    std::is_same_v<T, std::string>  ||
+    std::is_same_v<T, StrView>;
 } // namespace H
 
 /// An implementation of any which doesn't use dynamic allocation.
@@ -748,6 +827,14 @@ public:
     Value.Unsigned = V;
   }
 
+  FmtValue(long V) : Type(SignedLLType) {
+    Value.SignedLL = V;
+  }
+
+  FmtValue(unsigned long V) : Type(UnsignedLLType) {
+    Value.UnsignedLL = V;
+  }
+
   FmtValue(long long V) : Type(SignedLLType) {
     Value.SignedLL = V;
   }
@@ -799,7 +886,9 @@ enum class BaseType : RawBaseType {
 };
 
 enum class ExtraType {
-  None, Uppercase, Char, Ptr,
+  None, Uppercase, Char, Ptr, LinePrefix,
+  UrlEncode, HtmlEscape, Name,
+  Fixed, FixedTrim,
   Default = None
 };
 
@@ -857,6 +946,15 @@ public:
   bool isLiteral() const { return Type == RType::Literal; }
   bool isFormat()  const { return Type == RType::Format; }
   bool hasDynAlign() const { return Align == dynamicAlign; }
+  bool hasLinePrefix() const { return Extra == ExtraType::LinePrefix; }
+  bool isEscaped() const {
+    return Extra == ExtraType::UrlEncode
+        || Extra == ExtraType::HtmlEscape;
+  }
+  bool isFixed() const {
+    return Extra == ExtraType::Fixed
+        || Extra == ExtraType::FixedTrim;
+  }
 
 public:
   RType Type = RType::Empty;
@@ -866,23 +964,65 @@ public:
   std::size_t Align = 0;
   AlignType Side = AlignType::Default;
   char Pad = '\0';
+  /// The string inserted after each newline with `%l`.
+  StrView Prefix;
+  /// The number of fractional digits with `%.Nq`.
+  std::size_t Precision = 0;
 };
 
-struct Formatter {
-  Formatter(SmallBufBase& Buf, StrView Str, 
-    bool Permissive = false) : 
-   FormatString(Str), Buf(Buf), IsPermissive(Permissive) {}
+struct EnumTable;
+enum class FmtError : std::uint8_t;
+
+/// Splits a format string into literals and replacements.
+/// Shared by `Formatter` and `Scanner`, so both use one grammar.
+struct FmtParser {
+  explicit FmtParser(StrView Str) : FormatString(Str) {}
 public:
-  SmallBufBase* operator->() const { return &Buf; }
-  bool isPermissive() const { return this->IsPermissive; }
   const FmtReplacement& getLastReplacement() const& {
     return this->ParsedReplacement;
   }
 
+  /// Checks if any replacement spec was invalid. These are
+  /// reported, and parsed as if they were empty.
+  bool hasErrors() const { return this->HasErrors; }
+
   bool parseNextReplacement();
+  /// @return `false` if the spec was invalid, and the default was used.
   bool parseReplacementSpec(StrView Spec);
+
+protected:
+  /// Reports an error, unless they're muted for this parser.
+  void report(FmtError Error, StrView Spec) const;
+  void setReplacementSubstr(std::size_t Len = StrView::npos);
+  void setReplacementSubstr(std::size_t Pos, std::size_t Len);
+  StrView collectBraces() const;
+
+protected:
+  StrView FormatString;
+  FmtReplacement ParsedReplacement;
+  bool HasErrors = false;
+  bool MuteErrors = false;
+};
+
+struct Formatter : public FmtParser {
+  Formatter(SmallBufBase& Buf, StrView Str, 
+    bool Permissive = false) : 
+   FmtParser(Str), Buf(Buf), IsPermissive(Permissive) {}
+public:
+  SmallBufBase* operator->() const { return &Buf; }
+  bool isPermissive() const { return this->IsPermissive; }
   void parseWith(FmtValue::List Values);
 
+  /// Checks every replacement in `Str` against the argument types,
+  /// reporting any errors. Doesn't write anything.
+  /// @return `true` if the arguments can be formatted with `Str`.
+  static bool validate(StrView Str, FmtValue::List Values);
+
+  /// Writes `msg=Message`, then alternating keys and values,
+  /// as logfmt. Values are quoted only when needed. Keys which would
+  /// need quotes, and a last key without a value, are reported.
+  void logfmtWith(StrView Message, FmtValue::List Values);
+
 public:
   static int CountDigits(long long Value, BaseSink Base);
   static int CountDigits(unsigned long long Value, BaseSink Base);
@@ -900,18 +1040,533 @@ public:
   bool write(const AnyFmt& Generic) const;
   bool write(const SmallBufBase& InBuf) const;
 
+  /// Writes an enum by name with `%n`, or as an integer otherwise.
+  bool writeEnum(std::uint64_t Value, const EnumTable& Table) const;
+
 protected:
-  void setReplacementSubstr(std::size_t Len = StrView::npos);
-  void setReplacementSubstr(std::size_t Pos, std::size_t Len);
-  StrView collectBraces() const;
+  /// Formats ints, chars and plain strings through `Cur`,
+  /// with the padding written in the same pass.
+  /// @return `false` if the value needs the general path.
+  bool formatSimple(FmtValue Value, H::BufCursor& Cur) const;
+  bool writeLinePrefixed(const char* Str, std::size_t Len) const;
+  bool writeZeroPadded(FmtValue Value) const;
+  void writeLogfmtValue(const FmtValue& Value) const;
+  void writeLogfmtStr(StrView Str) const;
 
 private:
-  StrView FormatString;
-  FmtReplacement ParsedReplacement;
   SmallBufBase& Buf;
   const bool IsPermissive;
 };
 
+//=== Scanning ===//
+
+/// A reference to a value being scanned into.
+class ScanValue {
+  friend struct Scanner;
+
+  enum ValueType : std::uint8_t {
+    CharType,
+    SIntType,
+    UIntType,
+    StdStringType,
+    StringViewType
+  };
+
+  template <typename T>
+  static constexpr bool isIntTarget =
+    std::is_integral_v<T>       && 
+    !std::is_same_v<T, char>    &&
+    !std::is_same_v<T, bool>;
+
+public:
+  using List = std::initializer_list<ScanValue>;
+
+  ScanValue(char& C) : Data(&C), Type(CharType) {}
+  ScanValue(std::string& Str) : Data(&Str), Type(StdStringType) {}
+  ScanValue(StrView& Str) : Data(&Str), Type(StringViewType) {}
+
+  template <typename T,
+    typename = std::enable_if_t<isIntTarget<T>>>
+  ScanValue(T& Value) : Data(&Value),
+   Type(std::is_signed_v<T> ? SIntType : UIntType),
+   Size(std::uint8_t(sizeof(T))) {}
+
+public:
+  bool isIntType() const noexcept {
+    return Type == SIntType || Type == UIntType;
+  }
+
+  bool isStrType() const noexcept {
+    return Type == StdStringType || Type == StringViewType;
+  }
+
+  /// Reads the current value of an integer target.
+  long long getInt() const;
+
+  /// Assigns an integer, checking it fits the target.
+  /// @returns `false` if the value is out of range.
+  bool setInt(unsigned long long Magnitude, bool IsNegative) const;
+  void setStr(StrView Str) const;
+  void setChar(char C) const;
+
+private:
+  void* Data;
+  ValueType Type;
+  std::uint8_t Size = 0;
+};
+
+/// Parses input produced with the same format string.
+struct Scanner : public FmtParser {
+  Scanner(StrView Input, StrView Str) :
+   FmtParser(Str), Input(Input) {}
+public:
+  /// @return The number of values assigned.
+  std::size_t scanWith(ScanValue::List Values);
+
+  /// Gets the input which hasn't been consumed.
+  StrView getInput() const { return this->Input; }
+
+protected:
+  bool matchLiteral(StrView Literal);
+  bool scanValue(const ScanValue& Value);
+  /// Parses a signed integer in the current base, without assigning it.
+  /// @return The characters used, or `0` on failure.
+  std::size_t scanInt(StrView Field,
+    std::uint64_t& Magnitude, bool& IsNegative) const;
+  /// Finds where an unbounded string field ends.
+  std::size_t findFieldEnd(StrView Field) const;
+
+private:
+  StrView Input;
+};
+
+} // namespace sfmt
+
+//======================================================================//
+// Enums
+//======================================================================//
+
+namespace sfmt {
+
+/// A name table for an enum, generated by `SLIMFMT_[FLAG_]ENUM`.
+struct EnumTable {
+  /// Gets the name of the enumerator at `Idx`.
+  StrView getName(std::size_t Idx) const {
+    const std::size_t Off = Offsets[Idx];
+    return StrView(Names + Off, Offsets[Idx + 1] - Off);
+  }
+
+  /// Finds the name of `Value`.
+  /// @returns An empty string if `Value` isn't an enumerator.
+  StrView find(std::uint64_t Value) const;
+
+public:
+  const std::uint64_t* Values;
+  /// `Count + 1` offsets into `Names`.
+  const std::uint16_t* Offsets;
+  /// Maps each bit to an enumerator index, or `0xFF`.
+  const std::uint8_t* BitIndex;
+  const char* Names;
+  std::size_t Count;
+  bool IsDense;
+  bool IsFlags;
+  bool IsSigned;
+};
+
+namespace H {
+  /// Storage for an `EnumTable`, built at compile time
+  /// from the stringized list of enumerator names.
+  template <std::size_t N, std::size_t L>
+  struct EnumData {
+    static_assert(N < 0xFF, "Too many enumerators!");
+    static_assert(L <= 0xFFFF, "Enumerator names are too long!");
+  public:
+    constexpr EnumData(const char(&Str)[L],
+     const std::uint64_t(&Vals)[N], bool IsFlags) :
+     Values(), Offsets(), BitIndex(), Names(),
+     IsDense(true), IsFlags(IsFlags) {
+      std::size_t Out = 0, Ix = 0;
+      for (std::size_t I = 0; I < N; ++I) {
+        while (Ix < L && isSep(Str[Ix]))
+          ++Ix;
+        Offsets[I] = std::uint16_t(Out);
+        while (Ix < L && Str[Ix] && !isSep(Str[Ix]))
+          Names[Out++] = Str[Ix++];
+        Values[I] = Vals[I];
+        // Dense enums are contiguous, so they can be indexed.
+        IsDense = IsDense && (Vals[I] == Vals[0] + I);
+      }
+      Offsets[N] = std::uint16_t(Out);
+      for (auto& Idx : BitIndex)
+        Idx = 0xFF;
+      // The first single bit enumerator gets priority.
+      for (std::size_t I = N; I-- > 0;) {
+        const std::uint64_t V = Vals[I];
+        if (V == 0 || (V & (V - 1)) != 0)
+          continue;
+        int Bit = 0;
+        while (!((V >> Bit) & 1U))
+          ++Bit;
+        BitIndex[Bit] = std::uint8_t(I);
+      }
+    }
+
+    constexpr EnumTable getTable(bool IsSigned) const {
+      return {Values, Offsets, BitIndex, Names, 
+        N, IsDense, IsFlags, IsSigned};
+    }
+
+  private:
+    static constexpr bool isSep(char C) {
+      return C == ',' || C == ' ' || C == '\t' || C == '\n';
+    }
+  
+  public:
+    std::uint64_t Values[N];
+    std::uint16_t Offsets[N + 1];
+    std::uint8_t BitIndex[64];
+    char Names[L];
+    bool IsDense;
+    bool IsFlags;
+  };
+
+  template <std::size_t N, std::size_t L>
+  constexpr EnumData<N, L> makeEnumData(const char(&Str)[L],
+   const std::uint64_t(&Vals)[N], bool IsFlags) {
+    return EnumData<N, L>(Str, Vals, IsFlags);
+  }
+} // namespace H
+} // namespace sfmt
+
+#define SLIMFMT_PP_EXPAND(...) __VA_ARGS__
+#define SLIMFMT_PP_CAT_(x, y) x##y
+#define SLIMFMT_PP_CAT(x, y) SLIMFMT_PP_CAT_(x, y)
+#define SLIMFMT_PP_NARGS_(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30, _31, _32, _33, _34, _35, _36, _37, _38, _39, _40, _41, _42, _43, _44, _45, _46, _47, _48, _49, _50, _51, _52, _53, _54, _55, _56, _57, _58, _59, _60, _61, _62, _63, _64, N, ...) N
+#define SLIMFMT_PP_NARGS(...) SLIMFMT_PP_EXPAND( \
+  SLIMFMT_PP_NARGS_(__VA_ARGS__, 64, 63, 62, 61, 60, 59, 58, 57, 56, 55, 54, 53, 52, 51, 50, 49, 48, 47, 46, 45, 44, 43, 42, 41, 40, 39, 38, 37, 36, 35, 34, 33, 32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1))
+
+/// Applies `M(T, X)` to each argument `X`, up to 64 arguments.
+#define SLIMFMT_PP_MAP(M, T, ...) SLIMFMT_PP_EXPAND( \
+  SLIMFMT_PP_CAT(SLIMFMT_PP_MAP_, SLIMFMT_PP_NARGS(__VA_ARGS__))(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_1(M, T, X) M(T, X)
+#define SLIMFMT_PP_MAP_2(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_1(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_3(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_2(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_4(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_3(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_5(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_4(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_6(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_5(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_7(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_6(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_8(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_7(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_9(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_8(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_10(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_9(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_11(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_10(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_12(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_11(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_13(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_12(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_14(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_13(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_15(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_14(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_16(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_15(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_17(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_16(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_18(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_17(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_19(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_18(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_20(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_19(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_21(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_20(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_22(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_21(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_23(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_22(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_24(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_23(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_25(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_24(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_26(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_25(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_27(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_26(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_28(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_27(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_29(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_28(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_30(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_29(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_31(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_30(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_32(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_31(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_33(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_32(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_34(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_33(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_35(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_34(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_36(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_35(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_37(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_36(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_38(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_37(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_39(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_38(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_40(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_39(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_41(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_40(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_42(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_41(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_43(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_42(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_44(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_43(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_45(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_44(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_46(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_45(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_47(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_46(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_48(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_47(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_49(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_48(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_50(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_49(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_51(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_50(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_52(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_51(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_53(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_52(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_54(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_53(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_55(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_54(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_56(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_55(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_57(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_56(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_58(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_57(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_59(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_58(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_60(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_59(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_61(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_60(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_62(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_61(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_63(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_62(M, T, __VA_ARGS__))
+#define SLIMFMT_PP_MAP_64(M, T, X, ...) M(T, X) SLIMFMT_PP_EXPAND(SLIMFMT_PP_MAP_63(M, T, __VA_ARGS__))
+
+#define SLIMFMT_ENUM_VALUE_(Type, Name) static_cast<std::uint64_t>(Type::Name),
+
+#define SLIMFMT_ENUM_IMPL_(Type, IsFlags, ...)                      \
+  [[maybe_unused]] inline const ::sfmt::EnumTable&                  \
+   sfmt_enum_table(const Type&) {                                   \
+    static constexpr auto Data = ::sfmt::H::makeEnumData(           \
+      #__VA_ARGS__, { SLIMFMT_PP_MAP(SLIMFMT_ENUM_VALUE_,           \
+        Type, __VA_ARGS__) }, IsFlags);                             \
+    static constexpr ::sfmt::EnumTable Table = Data.getTable(       \
+      std::is_signed_v<std::underlying_type_t<Type>>);              \
+    return Table;                                                   \
+  }                                                                 \
+  [[maybe_unused]] inline void format_custom(                       \
+   const ::sfmt::Formatter& Fmt, const Type& Value) {               \
+    Fmt.writeEnum(static_cast<std::uint64_t>(Value),                \
+      sfmt_enum_table(Value));                                      \
+  }
+
+/// Registers the names of an enum, printed with `%n`.
+/// Must be used in the same namespace as `Type`.
+#define SLIMFMT_ENUM(Type, ...) \
+  SLIMFMT_ENUM_IMPL_(Type, false, __VA_ARGS__)
+
+/// Registers the names of a flag enum, printed as `A|B|C` with `%n`.
+/// Must be used in the same namespace as `Type`.
+#define SLIMFMT_FLAG_ENUM(Type, ...) \
+  SLIMFMT_ENUM_IMPL_(Type, true, __VA_ARGS__)
+
+//======================================================================//
+// JSON
+//======================================================================//
+
+namespace sfmt {
+
+/// Streams JSON directly into a buffer, without building a DOM.
+/// Commas are tracked with a bit per nesting level, so objects
+/// and arrays can be nested up to 63 levels deep. Anything deeper is
+/// reported as `FmtError::InvalidArgument` and written as `null`.
+class JsonWriter {
+public:
+  explicit JsonWriter(SmallBufBase& Buf) : Buf(Buf) {}
+
+public:
+  JsonWriter& beginObject();
+  JsonWriter& endObject();
+  JsonWriter& beginArray();
+  JsonWriter& endArray();
+
+  /// Writes an object key, which must be followed by a value.
+  JsonWriter& key(StrView Key);
+
+  JsonWriter& value(StrView Str);
+  JsonWriter& value(const char* Str);
+  JsonWriter& value(const std::string& Str) {
+    return this->value(StrView(Str));
+  }
+
+  JsonWriter& value(int V)                { return value((long long)V); }
+  JsonWriter& value(long V)               { return value((long long)V); }
+  JsonWriter& value(unsigned V)           { return value((unsigned long long)V); }
+  JsonWriter& value(unsigned long V)      { return value((unsigned long long)V); }
+  JsonWriter& value(long long V);
+  JsonWriter& value(unsigned long long V);
+  JsonWriter& value(bool V);
+  JsonWriter& value(std::nullptr_t);
+
+  /// Writes pre-serialized JSON as a value.
+  JsonWriter& rawValue(StrView Json);
+
+  /// Writes a key/value pair.
+  template <typename T>
+  JsonWriter& field(StrView Key, const T& Value) {
+    this->key(Key);
+    return this->value(Value);
+  }
+
+  /// Checks if every object and array has been closed.
+  bool isComplete() const { return Depth == 0; }
+
+private:
+  /// Writes a comma if this isn't the first element.
+  /// @return `false` if the element is too deep and must be dropped.
+  bool separate();
+  void writeString(StrView Str);
+  void push(char Open, bool IsObject);
+  void pop(char Close, bool IsObject);
+
+private:
+  SmallBufBase& Buf;
+  /// Set for each level which already has an element.
+  std::uint64_t HasElement = 0;
+  /// Set for each level which is an object.
+  std::uint64_t IsObject = 0;
+  std::uint32_t Depth = 0;
+  /// The levels opened past the limit, which aren't written.
+  std::uint32_t Dropped = 0;
+  bool AfterKey = false;
+};
+
+} // namespace sfmt
+
+//======================================================================//
+// Network
+//======================================================================//
+
+namespace sfmt {
+
+/// An IPv4 address in host byte order, eg. `0x7F000001` is `127.0.0.1`.
+struct IPv4Addr {
+  std::uint32_t Value;
+};
+
+/// An IPv6 address in network byte order.
+/// Prints with RFC 5952 zero compression, and `%X` for uppercase.
+struct IPv6Addr {
+  std::uint8_t Bytes[16];
+};
+
+/// A MAC address in network byte order.
+/// Prints as `aa:bb:cc:dd:ee:ff`, and `%X` for uppercase.
+struct MacAddr {
+  std::uint8_t Bytes[6];
+};
+
+inline IPv4Addr ipv4(std::uint32_t Value) {
+  return {Value};
+}
+
+inline IPv6Addr ipv6(const std::uint8_t(&Bytes)[16]) {
+  IPv6Addr Out;
+  std::memcpy(Out.Bytes, Bytes, sizeof(Out.Bytes));
+  return Out;
+}
+
+inline MacAddr mac(const std::uint8_t(&Bytes)[6]) {
+  MacAddr Out;
+  std::memcpy(Out.Bytes, Bytes, sizeof(Out.Bytes));
+  return Out;
+}
+
+/// Uses the lower 48 bits, eg. `0x0000'5E00'5301` is `00:00:5e:00:53:01`.
+inline MacAddr mac(std::uint64_t Value) {
+  MacAddr Out;
+  for (int Ix = 0; Ix < 6; ++Ix)
+    Out.Bytes[Ix] = std::uint8_t(Value >> (40 - Ix * 8));
+  return Out;
+}
+
+void format_custom(const Formatter& Fmt, const IPv4Addr& Addr);
+void format_custom(const Formatter& Fmt, const IPv6Addr& Addr);
+void format_custom(const Formatter& Fmt, const MacAddr& Addr);
+
+//=== Hex ===//
+
+/// A UUID in network byte order.
+/// Prints as `8-4-4-4-12` hex digits, and `%X` for uppercase.
+struct UuidValue {
+  std::uint8_t Bytes[16];
+};
+
+/// A view of bytes printed as exactly `Size * 2` hex digits,
+/// and `%X` for uppercase. Used for hashes and digests.
+struct HexBytes {
+  const std::uint8_t* Data;
+  std::size_t Size;
+};
+
+inline UuidValue uuid(const std::uint8_t(&Bytes)[16]) {
+  UuidValue Out;
+  std::memcpy(Out.Bytes, Bytes, sizeof(Out.Bytes));
+  return Out;
+}
+
+/// The bytes must outlive the format call.
+inline HexBytes hexFixed(const void* Bytes, std::size_t Size) {
+  return {static_cast<const std::uint8_t*>(Bytes), Size};
+}
+
+void format_custom(const Formatter& Fmt, const UuidValue& Uuid);
+void format_custom(const Formatter& Fmt, const HexBytes& Hex);
+
+} // namespace sfmt
+
+//======================================================================//
+// Big Integers
+//======================================================================//
+
+namespace sfmt {
+
+/// A view of an unsigned integer made of 64-bit limbs,
+/// with the least significant limb first.
+struct BigInt {
+  const std::uint64_t* Limbs;
+  std::size_t Size;
+};
+
+/// Formats `Size` limbs as a single integer, using the spec's base.
+/// The limbs must outlive the format call.
+inline BigInt bigint(const std::uint64_t* Limbs, std::size_t Size) {
+  return {Limbs, Size};
+}
+
+void format_custom(const Formatter& Fmt, const BigInt& Int);
+
+} // namespace sfmt
+
+//======================================================================//
+// Precompiled
+//======================================================================//
+
+namespace sfmt {
+
+/// A replacement parsed at build time by `slimfmt-extract`.
+/// The spec is stored as an offset into the format string.
+struct PrecompiledSpec {
+  std::uint32_t Offset;
+  std::uint32_t Size;
+  /// The width, or `~0U` for dynamic alignment.
+  std::uint32_t Align;
+  std::int8_t Base;
+  std::uint8_t Type;
+  std::uint8_t Extra;
+  std::uint8_t Side;
+  std::uint8_t Precision;
+  char Pad;
+};
+
+/// A format string and all of its replacements, in order.
+struct PrecompiledFormat {
+  const char* Str;
+  std::uint32_t Size;
+  std::uint32_t Count;
+  std::uint64_t Hash;
+  const PrecompiledSpec* Specs;
+};
+
+/// Links a table of formats, sorted by hash, into the global list.
+/// Each generated file defines one of these at namespace scope.
+struct PrecompiledBlock {
+  PrecompiledBlock(const PrecompiledFormat* Formats, std::size_t Count);
+public:
+  const PrecompiledFormat* Formats;
+  std::size_t Count;
+  PrecompiledBlock* Next = nullptr;
+};
+
+/// Hashes the contents of a format string.
+/// Used as the key of precompiled tables.
+std::uint64_t hashFormatString(StrView Str);
+
+/// Finds the precompiled replacements for `Str` by content.
+/// @return `nullptr` if the string wasn't precompiled.
+const PrecompiledFormat* findPrecompiled(StrView Str);
+
 } // namespace sfmt
 
 namespace sfmt {
@@ -942,7 +1597,7 @@ struct BasePrinter {
   template <std::size_t N, typename...TT>
   void operator()(const char(&Str)[N], TT&&...Args) const {
     SmallBufEstimateType<N> Buf;
-    this->printerRun({Str, N}, Buf, {SLIMFMT_ARG(Args)...});
+    this->printerRun({Str, N - 1}, Buf, {SLIMFMT_ARG(Args)...});
     this->defaultWrite(Buf);
   }
 
@@ -950,7 +1605,7 @@ struct BasePrinter {
   void operator()(std::FILE* File,
    const char(&Str)[N], TT&&...Args) const {
     SmallBufEstimateType<N> Buf;
-    this->printerRun({Str, N}, Buf, {SLIMFMT_ARG(Args)...});
+    this->printerRun({Str, N - 1}, Buf, {SLIMFMT_ARG(Args)...});
     Buf.writeTo(File);
   }
 
@@ -958,7 +1613,7 @@ struct BasePrinter {
   void operator()(std::ostream& Stream,
    const char(&Str)[N], TT&&...Args) const {
     SmallBufEstimateType<N> Buf;
-    this->printerRun({Str, N}, Buf, {SLIMFMT_ARG(Args)...});
+    this->printerRun({Str, N - 1}, Buf, {SLIMFMT_ARG(Args)...});
     Buf.writeTo(Stream);
   }
 
@@ -989,14 +1644,423 @@ extern Printer& err;
 extern Printer& outln;
 extern Printer& errln;
 
+/// Prints `msg` and key/value pairs as a logfmt line.
+/// For example, `logfmt("done", "status", 200)`.
+extern Printer& logfmt;
+
+//=== Log Printers ===//
+
+/// The severity of a message printed through a `LogPrinter`.
+enum class LogLevel : std::uint8_t {
+  Trace, Debug, Info, Warn, Error, Off
+};
+
+/// The configuration of a `LogPrinter`.
+struct LogConfig {
+  /// Messages below this level are dropped before formatting.
+  LogLevel Level = LogLevel::Info;
+  /// Colors warnings and errors.
+  bool Color = false;
+  /// Flushes the sink after every message.
+  bool FlushEach = false;
+  /// Adds a newline after every message.
+  bool AddLine = true;
+  /// Copied, and written before every message. Prefixes longer than
+  /// `LogPrinter::maxPrefix` are truncated, and reported.
+  StrView Prefix {};
+};
+
+/// A printer with its own sink and configuration, for when the
+/// global printers are too coarse (eg. one per subsystem).
+/// Calling it directly prints at `LogLevel::Info`, and `at` gets
+/// printers for the other levels. Both work as a `Printer&`.
+class LogPrinter : public BasePrinter {
+public:
+  /// Called with each formatted message.
+  using SinkFunc = void(*)(void* Data, StrView Message);
+
+  static constexpr std::size_t maxPrefix = 22;
+
+public:
+  explicit LogPrinter(std::FILE* File, const LogConfig& Cfg = {});
+  explicit LogPrinter(std::ostream& Stream, const LogConfig& Cfg = {});
+  LogPrinter(SinkFunc Func, void* Data, const LogConfig& Cfg = {});
+
+  /// The level printers point back to this object.
+  LogPrinter(const LogPrinter&) = delete;
+  LogPrinter& operator=(const LogPrinter&) = delete;
+
+public:
+  /// Gets a printer for messages at `Level`.
+  const BasePrinter& at(LogLevel Level) const;
+
+  bool isEnabled(LogLevel Level) const {
+    return Level >= State.Level.load(std::memory_order_relaxed)
+        && Level != LogLevel::Off;
+  }
+
+  /// @return The old level.
+  LogLevel setLevel(LogLevel Level) {
+    return State.Level.exchange(Level, std::memory_order_relaxed);
+  }
+
+  /// @return The old color mode value.
+  bool setColorMode(bool Value) {
+    return State.Color.exchange(Value, std::memory_order_relaxed);
+  }
+
+protected:
+  void printerRun(StrView Str, SmallBufBase& Buf,
+    FmtValue::List Values) const override;
+  void defaultWrite(SmallBufBase& Buf) const override;
+
+private:
+  struct LevelPrinter : public BasePrinter {
+    void printerRun(StrView Str, SmallBufBase& Buf,
+      FmtValue::List Values) const override;
+    void defaultWrite(SmallBufBase& Buf) const override;
+  public:
+    const LogPrinter* Parent = nullptr;
+    LogLevel Level = LogLevel::Info;
+  };
+
+  enum class SinkKind : std::uint8_t { File, Stream, Func };
+
+  void init(const LogConfig& Cfg);
+  void run(LogLevel Level, StrView Str,
+    SmallBufBase& Buf, FmtValue::List Values) const;
+  void write(SmallBufBase& Buf) const;
+
+private:
+  /// Everything read per message, in a single cache line.
+  struct alignas(64) StateType {
+    std::atomic<LogLevel> Level {LogLevel::Info};
+    std::atomic<bool> Color {false};
+    bool FlushEach = false;
+    bool AddLine = true;
+    SinkKind Kind = SinkKind::File;
+    std::uint8_t PrefixSize = 0;
+    char Prefix[maxPrefix] {};
+    void* Sink = nullptr;
+    SinkFunc Func = nullptr;
+  } State;
+  LevelPrinter Levels[std::size_t(LogLevel::Off)];
+};
+
+//=== Log Modules ===//
+
+/// A named group of `SLIMFMT_LOG` calls, with a runtime level mask.
+/// Define one with `SLIMFMT_LOG_MODULE(name)`.
+class alignas(64) LogModule {
+public:
+  /// Enables `Info` and above.
+  static constexpr std::uint64_t defaultMask = 0b11100;
+
+  explicit LogModule(const char* Name, std::uint64_t Mask = defaultMask);
+  LogModule(const LogModule&) = delete;
+  LogModule& operator=(const LogModule&) = delete;
+
+public:
+  static constexpr std::uint64_t maskFor(LogLevel Level) {
+    return std::uint64_t(1) << unsigned(Level);
+  }
+  /// Gets the mask enabling `Level` and above.
+  static constexpr std::uint64_t maskFrom(LogLevel Level) {
+    return ~(maskFor(Level) - 1) & (maskFor(LogLevel::Off) - 1);
+  }
+
+  bool isEnabled(LogLevel Level) const {
+    return Mask.load(std::memory_order_relaxed) & maskFor(Level);
+  }
+
+  /// @return The old mask.
+  std::uint64_t setMask(std::uint64_t Value) {
+    return Mask.exchange(Value, std::memory_order_relaxed);
+  }
+  std::uint64_t getMask() const {
+    return Mask.load(std::memory_order_relaxed);
+  }
+
+  /// Sends every level to `Out`, which is `errln` by default.
+  void setPrinter(const BasePrinter& Out);
+  /// Sends each level to `Out.at(Level)`.
+  void setPrinter(const LogPrinter& Out);
+
+  const char* getName() const { return this->Name; }
+  LogModule* getNext() const { return this->Next; }
+
+  template <std::size_t N, typename...TT>
+  void log(LogLevel Level, const char(&Str)[N], TT&&...Args) const {
+    (*this->getPrinter(Level))(Str, std::forward<TT>(Args)...);
+  }
+
+private:
+  const BasePrinter* getPrinter(LogLevel Level) const;
+
+private:
+  std::atomic<std::uint64_t> Mask;
+  std::atomic<const BasePrinter*> Printers[std::size_t(LogLevel::Off)] {};
+  const char* Name;
+  LogModule* Next = nullptr;
+};
+
+/// Gets the first registered module. Use `getNext` for the rest.
+LogModule* getLogModules();
+
+/// Finds a module by name.
+/// @return `nullptr` if there is no module called `Name`.
+LogModule* findLogModule(StrView Name);
+
+/// Defines a log module, usable in `SLIMFMT_LOG`. Can be used in headers.
+#define SLIMFMT_LOG_MODULE(name) \
+  inline ::sfmt::LogModule SLIMFMT_PP_CAT(slimfmtLogModule_, name) {#name}
+
+namespace H {
+  /// Kept out of the macro, as comparing against the default
+  /// floor of `0` warns with `-Wtype-limits` at every call site.
+  constexpr bool isAboveLogFloor(LogLevel Level) {
+    constexpr int Floor = SLIMFMT_LOG_FLOOR;
+    return int(Level) >= Floor;
+  }
+} // namespace H
+
+/// Logs to a module if the level is enabled, like
+/// `SLIMFMT_LOG(Warn, net, "retrying {}", Host)`. Levels below
+/// `SLIMFMT_LOG_FLOOR` are removed, and disabled levels are checked
+/// before any arguments are evaluated.
+#define SLIMFMT_LOG(level, module, ...) do { \
+  if constexpr (::sfmt::H::isAboveLogFloor(::sfmt::LogLevel::level)) { \
+    auto& SlimfmtMod_ = SLIMFMT_PP_CAT(slimfmtLogModule_, module); \
+    if (SlimfmtMod_.isEnabled(::sfmt::LogLevel::level)) \
+      SlimfmtMod_.log(::sfmt::LogLevel::level, __VA_ARGS__); \
+  } \
+} while (0)
+
+//=== Call Sites ===//
+
+/// Call sites can be found without running them on ELF targets, where
+/// descriptors are placed in a single section.
+#if defined(__ELF__) && (defined(__GNUC__) || defined(__clang__))
+# define SLIMFMT_HAS_CALL_SITES 1
+# define SLIMFMT_CALL_SITE_ATTR __attribute__((used, section("slimfmt_sites")))
+#else
+# define SLIMFMT_HAS_CALL_SITES 0
+# define SLIMFMT_CALL_SITE_ATTR
+#endif
+
+/// The descriptor of a `SLIMFMT_DEBUG` call site.
+/// Over-aligned so the compiler never pads between sites.
+struct alignas(32) CallSite {
+  std::atomic<bool> Enabled;
+  std::uint32_t Line;
+  const char* Format;
+  const char* File;
+  const char* Module;
+};
+
+struct CallSiteRange {
+  CallSite* begin() const { return First; }
+  CallSite* end() const { return Last; }
+  std::size_t size() const { return std::size_t(Last - First); }
+public:
+  CallSite* First = nullptr;
+  CallSite* Last = nullptr;
+};
+
+/// Gets every `SLIMFMT_DEBUG` call site linked into the executable.
+/// Empty when `SLIMFMT_HAS_CALL_SITES` is 0.
+CallSiteRange getCallSites();
+
+/// Enables or disables the call sites matching a query, such as
+/// `module net file conn.cpp line 10-40 format retry +p`.
+/// `file` matches a suffix, `format` a substring, and `-p` disables.
+/// @return The number of call sites matched.
+std::size_t applyDebugControl(StrView Command);
+
+/// Applies each line of a control file, ignoring `#` comments.
+/// @return The number of call sites matched, or -1 if it can't be read.
+long loadDebugControl(const char* Path);
+
+/// Reloads the control file in a background thread each time the
+/// process receives `Signal` (eg. `SIGUSR1`). Can only be called once.
+/// @return `false` if unsupported, or already watching.
+bool watchDebugControl(const char* Path, int Signal);
+
+#define SLIMFMT_PP_FIRST_(x, ...) x
+#define SLIMFMT_PP_FIRST(...) SLIMFMT_PP_EXPAND(SLIMFMT_PP_FIRST_(__VA_ARGS__, ~))
+
+/// A debug message which is disabled until its call site is enabled
+/// at runtime, like `SLIMFMT_DEBUG(net, "sent {} bytes", Len)`.
+/// Disabled sites cost a load and a branch.
+#define SLIMFMT_DEBUG(module, ...) do { \
+  SLIMFMT_CALL_SITE_ATTR static ::sfmt::CallSite SlimfmtSite_ { \
+    {false}, __LINE__, SLIMFMT_PP_FIRST(__VA_ARGS__), __FILE__, #module}; \
+  if SLIMFMT_UNLIKELY(SlimfmtSite_.Enabled.load(std::memory_order_relaxed)) \
+    SLIMFMT_PP_CAT(slimfmtLogModule_, module) \
+      .log(::sfmt::LogLevel::Debug, __VA_ARGS__); \
+} while (0)
+
+//=== Shared Memory Rings ===//
+
+/// A ring of fixed-size message slots in shared memory, for handing
+/// logs to another process without a syscall per message.
+/// Any number of processes may write, and one may read. Writers claim
+/// a slot with a CAS, so each slot has a single producer, and never
+/// block: messages are dropped when the ring is full, and truncated
+/// when longer than a slot. The reader only sleeps (on a futex) when
+/// the ring is empty, and writers only wake it in that case.
+/// A writer killed between claiming and filling a slot stalls the reader.
+/// Invalid when unsupported (anything but Linux) or on failure.
+class ShmRing {
+public:
+  /// Counters shared by every process using the ring.
+  struct Stats {
+    std::uint64_t Written = 0;
+    std::uint64_t Dropped = 0;
+    std::uint64_t Wakeups = 0;
+  };
+
+public:
+  ShmRing() = default;
+  ShmRing(ShmRing&& Other) noexcept;
+  ShmRing& operator=(ShmRing&& Other) noexcept;
+  ~ShmRing();
+
+  /// Creates a ring of `SlotCount` slots of `SlotSize` bytes, both
+  /// powers of 2. It is backed by a `memfd`, unless `Name` starts
+  /// with `/`, in which case it is a (replaced) POSIX shm object.
+  static ShmRing create(const char* Name,
+    std::uint32_t SlotCount, std::uint32_t SlotSize = 256);
+  /// Maps a ring from a descriptor, eg. one inherited by a child.
+  static ShmRing attach(int Fd);
+  /// Maps a ring created with a `/` prefixed name.
+  static ShmRing attach(const char* Name);
+
+public:
+  explicit operator bool() const { return Hdr != nullptr; }
+  int getFd() const { return Fd; }
+  std::size_t getSlotCount() const;
+  /// The longest message which isn't truncated.
+  std::size_t getMaxMessage() const;
+  Stats getStats() const;
+
+  /// Copies `Message` into the next free slot.
+  /// @return `false` if the ring was full.
+  bool write(StrView Message);
+
+  /// Takes the oldest message. Waits up to `TimeoutMs` for one,
+  /// or forever if negative. Only one process may read at a time.
+  /// @return `false` on timeout.
+  bool read(std::string& Out, int TimeoutMs = -1);
+
+  /// A `LogPrinter::SinkFunc`, where `Ring` is a `ShmRing*`.
+  static void sink(void* Ring, StrView Message) {
+    (void) static_cast<ShmRing*>(Ring)->write(Message);
+  }
+
+private:
+  struct Header;
+  struct Slot;
+  ShmRing(int Fd, Header* Hdr, std::size_t MapSize) :
+   Hdr(Hdr), MapSize(MapSize), Fd(Fd) {}
+  /// Maps `Fd` without checking the header, for `create`.
+  static ShmRing map(int Fd, std::size_t Size);
+  Slot* getSlot(std::uint64_t Pos) const;
+  void reset();
+
+private:
+  Header* Hdr = nullptr;
+  std::size_t MapSize = 0;
+  int Fd = -1;
+};
+
 template <std::size_t N, typename...TT>
 std::string format(const char(&Str)[N], TT&&...Args) {
   SmallBufEstimateType<N> Buf;
-  Formatter Fmt {Buf, {Str, N}};
+  Formatter Fmt {Buf, {Str, N - 1}};
   Fmt.parseWith({SLIMFMT_ARG(Args)...});
   return std::string(Buf.begin(), Buf.end());
 }
 
+/// The output of `formatBuf`. Short results are stored inline, and
+/// longer ones keep the formatter's heap buffer, so nothing is copied.
+/// Views of the result are invalidated when it is moved.
+class FormatResult {
+  template <std::size_t N, typename...TT>
+  friend FormatResult formatBuf(const char(&)[N], TT&&...);
+public:
+  /// Keeps the whole object at 128 bytes.
+  static constexpr std::size_t inlineSize = 104;
+
+  FormatResult() = default;
+  FormatResult(FormatResult&&) = default;
+  FormatResult& operator=(FormatResult&&) = default;
+
+public:
+  const char* data() const { return Buf.data(); }
+  std::size_t size() const { return Buf.size(); }
+  bool empty() const { return Buf.isEmpty(); }
+
+  StrView str() const { return StrView(Buf.data(), Buf.size()); }
+  operator StrView() const { return this->str(); }
+
+  const char* begin() const { return Buf.begin(); }
+  const char* end() const { return Buf.end(); }
+
+private:
+  SmallBuf<inlineSize> Buf;
+};
+
+/// Like `format`, but doesn't copy the result into a `std::string`.
+template <std::size_t N, typename...TT>
+FormatResult formatBuf(const char(&Str)[N], TT&&...Args) {
+  FormatResult Result;
+  Formatter Fmt {Result.Buf, {Str, N - 1}};
+  Fmt.parseWith({SLIMFMT_ARG(Args)...});
+  return Result;
+}
+
+/// Parses `Input` using the same grammar as `format`.
+/// @return The number of arguments assigned.
+template <std::size_t N, typename...TT>
+std::size_t scan(StrView Input, const char(&Str)[N], TT&...Args) {
+  Scanner Scn {Input, {Str, N - 1}};
+  return Scn.scanWith({ScanValue(Args)...});
+}
+
+/// Writes `Value` to `[First, Last)` in a base in the range `[2, 36]`,
+/// using the same kernels as `Formatter`. Nothing is null terminated.
+/// @return The end of the digits, or `nullptr` if they don't fit
+/// or the base is invalid. Nothing is written on failure.
+char* toChars(char* First, char* Last,
+  long long Value, int Base = 10, bool Upper = false);
+char* toChars(char* First, char* Last,
+  unsigned long long Value, int Base = 10, bool Upper = false);
+
+template <typename T, typename = 
+  std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>>
+char* toChars(char* First, char* Last,
+ T Value, int Base = 10, bool Upper = false) {
+  if constexpr (std::is_signed_v<T>)
+    return toChars(First, Last, (long long)Value, Base, Upper);
+  else
+    return toChars(First, Last, (unsigned long long)Value, Base, Upper);
+}
+
+/// Gets the number of characters `toChars` will write, including the sign.
+/// @return `-1` if the base isn't in the range `[2, 36]`.
+int countDigits(long long Value, int Base = 10);
+int countDigits(unsigned long long Value, int Base = 10);
+
+template <typename T, typename = 
+  std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>>
+int countDigits(T Value, int Base = 10) {
+  if constexpr (std::is_signed_v<T>)
+    return countDigits((long long)Value, Base);
+  else
+    return countDigits((unsigned long long)Value, Base);
+}
+
 void flush(std::FILE* File);
 void flush(std::ostream& Stream);
 
@@ -1004,6 +2068,52 @@ void flush(std::ostream& Stream);
 /// @return The old color mode value.
 bool setColorMode(bool Value);
 
+/// The kinds of errors caught while formatting or scanning.
+enum class FmtError : std::uint8_t {
+  InvalidSpec, InvalidWidth, InvalidBase, InvalidPrecision,
+  Unterminated, MissingArgument, ExtraArgument,
+  InvalidArgument
+};
+
+/// Called with an error and the spec it occurred in.
+/// Must not throw, and should not allocate.
+using ErrorHandler = void(*)(FmtError Error, StrView Spec);
+
+/// @brief Sets the function called on errors. Errors are always
+/// counted, so `nullptr` (the default) only counts them.
+/// @return The old handler.
+ErrorHandler setErrorHandler(ErrorHandler Handler);
+
+/// Gets the number of errors reported since startup.
+std::uint64_t getErrorCount();
+
+/// Counts of the buffers mapped at or above `SLIMFMT_HUGE_PAGE_THRESHOLD`.
+struct HugePageStats {
+  std::uint64_t Mapped = 0;
+  /// Mapped with explicit huge pages (`MAP_HUGETLB`).
+  std::uint64_t Explicit = 0;
+  /// Mapped normally, and advised to use transparent huge pages.
+  /// These may still be backed by normal pages, see `hasHugePages`.
+  std::uint64_t Advised = 0;
+  /// Grown in place with `mremap`, instead of being copied.
+  std::uint64_t Remapped = 0;
+};
+
+/// Gets the huge page counters since startup.
+HugePageStats getHugePageStats();
+
+/// Checks if the mapping containing `Ptr` is actually backed by huge pages.
+/// This reads `/proc/self/smaps`, so it's only meant for diagnostics.
+/// Always `false` when huge pages aren't supported.
+bool hasHugePages(const void* Ptr);
+
+/// Gets a static description of the error.
+const char* getErrorMessage(FmtError Error);
+
+/// A handler which prints the first 16 errors to `stderr`,
+/// and ignores the rest.
+void stderrErrorHandler(FmtError Error, StrView Spec);
+
 } // namespace sfmt
 
 #endif // SLIMFMT_HSLIMFMT_HPP
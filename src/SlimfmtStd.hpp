@@ -0,0 +1,140 @@
+//===- SlimfmtStd.hpp -----------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+// Opt-in formatting for `std::optional`, `std::variant`, `std::pair`
+// and `std::tuple`. This is kept out of the main header so users who
+// don't need it don't pay for the extra includes.
+//
+//===----------------------------------------------------------------===//
+
+#pragma once
+
+#ifndef SLIMFMT_HSLIMFMTSTD_HPP
+#define SLIMFMT_HSLIMFMTSTD_HPP
+
+#include "Slimfmt.hpp"
+#include <optional>
+#include <tuple>
+#include <variant>
+
+namespace sfmt {
+
+/// The brackets and separator used for tuple-like types.
+/// Specialize this to change the defaults for a type.
+template <typename T>
+struct StdFormatStyle {
+  static constexpr StrView Open  = "(";
+  static constexpr StrView Sep   = ", ";
+  static constexpr StrView Close = ")";
+};
+
+/// Wraps a tuple-like value to print with a custom style.
+template <typename T>
+struct StyledTuple {
+  const T& Value;
+  StrView Open, Sep, Close;
+};
+
+/// Prints a `std::pair` or `std::tuple` with a custom style.
+template <typename T>
+StyledTuple<T> styled(const T& Value, StrView Sep,
+ StrView Open = "(", StrView Close = ")") {
+  return {Value, Open, Sep, Close};
+}
+
+namespace H {
+  /// Writes a single element with the parent's spec.
+  template <typename T>
+  inline void writeElement(const Formatter& Fmt, const T& Value) {
+    Fmt.write(SLIMFMT_ARG(Value));
+  }
+
+  template <typename T, std::size_t...II>
+  inline void writeTuple(const Formatter& Fmt, const T& Tup,
+   StrView Open, StrView Sep, StrView Close, std::index_sequence<II...>) {
+    Fmt->appendStr(Open);
+    ((II == 0 ? void() : Fmt->appendStr(Sep),
+      H::writeElement(Fmt, std::get<II>(Tup))), ...);
+    Fmt->appendStr(Close);
+  }
+
+  template <typename T>
+  inline void writeTuple(const Formatter& Fmt, const T& Tup,
+   StrView Open, StrView Sep, StrView Close) {
+    constexpr std::size_t N = std::tuple_size_v<T>;
+    H::writeTuple(Fmt, Tup, Open, Sep, Close,
+      std::make_index_sequence<N>{});
+  }
+
+  template <typename T>
+  inline void writeTuple(const Formatter& Fmt, const T& Tup) {
+    using Style = StdFormatStyle<T>;
+    H::writeTuple(Fmt, Tup, Style::Open, Style::Sep, Style::Close);
+  }
+} // namespace H
+
+//======================================================================//
+// Overloads
+//======================================================================//
+
+template <typename T>
+void format_custom(const Formatter& Fmt, const StyledTuple<T>& Styled) {
+  H::writeTuple(Fmt, Styled.Value, 
+    Styled.Open, Styled.Sep, Styled.Close);
+}
+
+template <typename A, typename B>
+void format_custom(const Formatter& Fmt, const std::pair<A, B>& Pair) {
+  H::writeTuple(Fmt, Pair);
+}
+
+template <typename...TT>
+void format_custom(const Formatter& Fmt, const std::tuple<TT...>& Tup) {
+  H::writeTuple(Fmt, Tup);
+}
+
+inline void format_custom(const Formatter& Fmt, std::nullopt_t) {
+  Fmt->appendStr("none");
+}
+
+template <typename T>
+void format_custom(const Formatter& Fmt, const std::optional<T>& Opt) {
+  if (Opt.has_value())
+    H::writeElement(Fmt, *Opt);
+  else
+    Fmt->appendStr("none");
+}
+
+inline void format_custom(const Formatter& Fmt, std::monostate) {
+  Fmt->appendStr("monostate");
+}
+
+template <typename...TT>
+void format_custom(const Formatter& Fmt, const std::variant<TT...>& Var) {
+  if SLIMFMT_UNLIKELY(Var.valueless_by_exception()) {
+    Fmt->appendStr("valueless");
+    return;
+  }
+  std::visit([&Fmt] (const auto& Value) {
+    H::writeElement(Fmt, Value);
+  }, Var);
+}
+
+} // namespace sfmt
+
+#endif // SLIMFMT_HSLIMFMTSTD_HPP
@@ -0,0 +1,466 @@
+//===- SlimfmtExtract.cpp -------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+// Scans sources for `sfmt::` calls and logging macros with literal
+// format strings, parses them with `FmtParser`, and writes a file
+// containing the replacement tables. See `slimfmt_add_precompiled` in CMakeLists.txt.
+//
+//     slimfmt-extract <output.cpp> <sources...>
+//
+//===----------------------------------------------------------------===//
+
+#include <Slimfmt.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace sfmt;
+
+namespace {
+  /// The functions which take a format string as the first
+  /// or second (after a stream) argument.
+  const char* const formatNames[] {
+    "format", "formatBuf", "print", "println", "out", "err",
+    "outln", "errln", "null", "nulls", "test"
+  };
+
+  struct Source {
+    StrView Text;
+    std::size_t Pos = 0;
+    unsigned Line = 1;
+  };
+
+  bool isIdentChar(char C) {
+    return (C >= 'a' && C <= 'z') || (C >= 'A' && C <= 'Z')
+        || (C >= '0' && C <= '9') || C == '_';
+  }
+
+  char peek(const Source& Src, std::size_t Off = 0) {
+    const std::size_t Pos = Src.Pos + Off;
+    return (Pos < Src.Text.size()) ? Src.Text[Pos] : '\0';
+  }
+
+  void advance(Source& Src, std::size_t N = 1) {
+    for (; N && Src.Pos < Src.Text.size(); --N)
+      Src.Line += (Src.Text[Src.Pos++] == '\n');
+  }
+
+  /// Skips a quoted literal starting at the current quote.
+  void skipQuoted(Source& Src) {
+    const char Quote = peek(Src);
+    advance(Src);
+    while (Src.Pos < Src.Text.size() && peek(Src) != Quote) {
+      if (peek(Src) == '\\')
+        advance(Src);
+      advance(Src);
+    }
+    advance(Src);
+  }
+
+  /// Skips a raw string, starting at the quote after `R`.
+  void skipRawString(Source& Src) {
+    const std::size_t Open = Src.Text.find('(', Src.Pos);
+    if (Open == StrView::npos) {
+      advance(Src, Src.Text.size());
+      return;
+    }
+    std::string Close = ")";
+    Close.append(Src.Text.substr(Src.Pos + 1, Open - Src.Pos - 1));
+    Close.push_back('"');
+    const std::size_t End = Src.Text.find(Close, Open);
+    advance(Src, (End == StrView::npos)
+      ? Src.Text.size() : (End + Close.size() - Src.Pos));
+  }
+
+  /// Skips whitespace and comments.
+  void skipSpace(Source& Src) {
+    while (Src.Pos < Src.Text.size()) {
+      const char C = peek(Src);
+      if (C == ' ' || C == '\t' || C == '\n' || C == '\r') {
+        advance(Src);
+      } else if (C == '/' && peek(Src, 1) == '/') {
+        while (Src.Pos < Src.Text.size() && peek(Src) != '\n')
+          advance(Src);
+      } else if (C == '/' && peek(Src, 1) == '*') {
+        const std::size_t End = Src.Text.find("*/", Src.Pos + 2);
+        advance(Src, (End == StrView::npos)
+          ? Src.Text.size() : (End + 2 - Src.Pos));
+      } else {
+        break;
+      }
+    }
+  }
+
+  int hexValue(char C) {
+    if (C >= '0' && C <= '9') return C - '0';
+    if (C >= 'a' && C <= 'f') return C - 'a' + 10;
+    if (C >= 'A' && C <= 'F') return C - 'A' + 10;
+    return -1;
+  }
+
+  /// Decodes one ordinary string literal into `Out`.
+  /// @return `false` if it uses escapes which aren't handled.
+  bool readQuoted(Source& Src, std::string& Out) {
+    advance(Src);
+    while (Src.Pos < Src.Text.size()) {
+      char C = peek(Src);
+      advance(Src);
+      if (C == '"')
+        return true;
+      if (C == '\n')
+        return false;
+      if (C != '\\') {
+        Out.push_back(C);
+        continue;
+      }
+      C = peek(Src);
+      advance(Src);
+      switch (C) {
+        case 'n': Out.push_back('\n'); break;
+        case 't': Out.push_back('\t'); break;
+        case 'r': Out.push_back('\r'); break;
+        case 'a': Out.push_back('\a'); break;
+        case 'b': Out.push_back('\b'); break;
+        case 'f': Out.push_back('\f'); break;
+        case 'v': Out.push_back('\v'); break;
+        case 'e': Out.push_back('\x1B'); break;
+        case '\\': case '\'': case '"': case '?':
+          Out.push_back(C);
+          break;
+        case 'x': {
+          unsigned Value = 0;
+          int Digit;
+          while ((Digit = hexValue(peek(Src))) >= 0) {
+            Value = (Value << 4) | unsigned(Digit);
+            advance(Src);
+          }
+          Out.push_back(char(Value));
+          break;
+        }
+        default: {
+          if (C < '0' || C > '7')
+            return false;
+          unsigned Value = unsigned(C - '0');
+          for (int Ix = 0; Ix < 2 && peek(Src) >= '0' && peek(Src) <= '7'; ++Ix) {
+            Value = (Value << 3) | unsigned(peek(Src) - '0');
+            advance(Src);
+          }
+          Out.push_back(char(Value));
+        }
+      }
+    }
+    return false;
+  }
+
+  /// Reads a sequence of adjacent string literals, which must
+  /// be the entire argument.
+  bool readLiteralArg(Source& Src, std::string& Out) {
+    skipSpace(Src);
+    if (peek(Src) != '"')
+      return false;
+    while (peek(Src) == '"') {
+      if (!readQuoted(Src, Out))
+        return false;
+      skipSpace(Src);
+    }
+    return peek(Src) == ',' || peek(Src) == ')';
+  }
+
+  /// Skips to the next top level `,`, or the closing `)`.
+  /// @return `true` if a comma was found.
+  bool skipArg(Source& Src) {
+    int Depth = 0;
+    while (Src.Pos < Src.Text.size()) {
+      skipSpace(Src);
+      const char C = peek(Src);
+      if (C == '"' || C == '\'') {
+        skipQuoted(Src);
+        continue;
+      }
+      if (C == '(' || C == '[' || C == '{') {
+        ++Depth;
+      } else if (C == ')' || C == ']' || C == '}') {
+        if (Depth-- == 0)
+          return false;
+      } else if (C == ',' && Depth == 0) {
+        advance(Src);
+        return true;
+      }
+      advance(Src);
+    }
+    return false;
+  }
+
+  /// Checks if `Macro (` is at the current position.
+  bool matchMacro(Source& Src, StrView Macro) {
+    if (Src.Text.compare(Src.Pos, Macro.size(), Macro) != 0 ||
+     isIdentChar(peek(Src, Macro.size())))
+      return false;
+    Source Tmp = Src;
+    advance(Tmp, Macro.size());
+    skipSpace(Tmp);
+    if (peek(Tmp) != '(')
+      return false;
+    advance(Tmp);
+    Src = Tmp;
+    return true;
+  }
+
+  /// Checks if `sfmt :: name (` or a logging macro is at the current
+  /// position, and moves past it if so.
+  /// @param First The first argument which may be the format string.
+  /// @param Last The last argument which may be the format string.
+  bool matchCall(Source& Src, int& First, int& Last) {
+    if (matchMacro(Src, "SLIMFMT_LOG")) {
+      // Skips the level and module.
+      First = Last = 2;
+      return true;
+    }
+    if (matchMacro(Src, "SLIMFMT_DEBUG")) {
+      First = Last = 1;
+      return true;
+    }
+    if (Src.Text.compare(Src.Pos, 4, "sfmt") != 0 || isIdentChar(peek(Src, 4)))
+      return false;
+    Source Tmp = Src;
+    advance(Tmp, 4);
+    skipSpace(Tmp);
+    if (peek(Tmp) != ':' || peek(Tmp, 1) != ':')
+      return false;
+    advance(Tmp, 2);
+    skipSpace(Tmp);
+    std::string Name;
+    while (isIdentChar(peek(Tmp))) {
+      Name.push_back(peek(Tmp));
+      advance(Tmp);
+    }
+    skipSpace(Tmp);
+    if (peek(Tmp) != '(')
+      return false;
+    if (std::find(std::begin(formatNames), std::end(formatNames), Name)
+     == std::end(formatNames))
+      return false;
+    advance(Tmp);
+    Src = Tmp;
+    // The first argument may be a stream.
+    First = 0, Last = 1;
+    return true;
+  }
+
+  /// Collects the literal format strings in a file.
+  void scanSource(Source& Src, std::map<std::string, unsigned>& Out) {
+    while (Src.Pos < Src.Text.size()) {
+      skipSpace(Src);
+      const char C = peek(Src);
+      if (C == '"') {
+        // Raw strings are never treated as format strings.
+        if (Src.Pos > 0 && Src.Text[Src.Pos - 1] == 'R')
+          skipRawString(Src);
+        else
+          skipQuoted(Src);
+        continue;
+      }
+      // Skip char literals, but not digit separators.
+      if (C == '\'' && !(Src.Pos > 0 && isIdentChar(Src.Text[Src.Pos - 1]))) {
+        skipQuoted(Src);
+        continue;
+      }
+      if (Src.Pos > 0 && isIdentChar(Src.Text[Src.Pos - 1])) {
+        advance(Src);
+        continue;
+      }
+      int First = 0, Last = 0;
+      if (!matchCall(Src, First, Last)) {
+        advance(Src);
+        continue;
+      }
+      const unsigned Line = Src.Line;
+      for (int Arg = 0; Arg <= Last; ++Arg) {
+        if (Arg < First) {
+          if (!skipArg(Src))
+            break;
+          continue;
+        }
+        Source Tmp = Src;
+        std::string Str;
+        if (readLiteralArg(Tmp, Str)) {
+          Out.emplace(std::move(Str), Line);
+          break;
+        }
+        if (!skipArg(Src))
+          break;
+      }
+    }
+  }
+
+  //=== Output ===//
+
+  struct Parsed {
+    std::string Str;
+    std::uint64_t Hash = 0;
+    std::vector<PrecompiledSpec> Specs;
+  };
+
+  static bool hadError = false;
+  static void recordError(FmtError, StrView) {
+    hadError = true;
+  }
+
+  /// Parses `Str` exactly as the formatter would.
+  /// @return `false` if the string can't be stored in the table.
+  bool parseFormat(const std::string& Str, Parsed& Out) {
+    const StrView View {Str};
+    FmtParser Parser {View};
+    hadError = false;
+    while (Parser.parseNextReplacement()) {
+      const FmtReplacement& R = Parser.getLastReplacement();
+      if (R.isEmpty() || hadError)
+        return false;
+      PrecompiledSpec Spec {};
+      Spec.Offset = std::uint32_t(R.Data.data() - View.data());
+      Spec.Size = std::uint32_t(R.Data.size());
+      Spec.Type = std::uint8_t(R.Type);
+      if (R.isFormat()) {
+        if (R.hasDynAlign())
+          Spec.Align = ~std::uint32_t(0);
+        else if (R.Align >= ~std::uint32_t(0))
+          return false;
+        else
+          Spec.Align = std::uint32_t(R.Align);
+        Spec.Base = std::int8_t(RawBaseType(R.Base));
+        Spec.Extra = std::uint8_t(R.Extra);
+        Spec.Side = std::uint8_t(R.Side);
+        Spec.Precision = std::uint8_t(R.Precision);
+        Spec.Pad = R.Pad;
+      }
+      Out.Specs.push_back(Spec);
+    }
+    // A failed parse leaves an empty replacement.
+    if (hadError || Out.Specs.empty())
+      return false;
+    Out.Str = Str;
+    Out.Hash = hashFormatString(View);
+    return true;
+  }
+
+  /// Writes `Str` as a literal, escaping everything but plain ASCII.
+  void writeLiteral(std::ostream& OS, const std::string& Str) {
+    static const char Digits[] = "01234567";
+    OS << '"';
+    for (const char C : Str) {
+      const auto U = static_cast<unsigned char>(C);
+      if (U < 0x20 || U >= 0x7F || C == '"' || C == '\\' || C == '?') {
+        const char Esc[] {'\\',
+          Digits[(U >> 6) & 7], Digits[(U >> 3) & 7], Digits[U & 7]};
+        OS.write(Esc, 4);
+      } else {
+        OS << C;
+      }
+    }
+    OS << '"';
+  }
+
+  void writeTables(std::ostream& OS, std::vector<Parsed>& Formats) {
+    std::sort(Formats.begin(), Formats.end(),
+      [] (const Parsed& Lhs, const Parsed& Rhs) {
+        return Lhs.Hash < Rhs.Hash;
+      });
+    OS << "// Generated by slimfmt-extract. Do not edit.\n\n";
+    OS << "#include <Slimfmt.hpp>\n\n";
+    OS << "namespace {\n";
+    for (std::size_t Ix = 0; Ix < Formats.size(); ++Ix) {
+      OS << "const sfmt::PrecompiledSpec specs" << Ix << "[] {\n";
+      for (const PrecompiledSpec& S : Formats[Ix].Specs) {
+        OS << "  {" << S.Offset << ", " << S.Size << ", " << S.Align
+           << "U, " << int(S.Base) << ", " << int(S.Type)
+           << ", " << int(S.Extra) << ", " << int(S.Side)
+           << ", " << int(S.Precision) << ", " << int(S.Pad) << "},\n";
+      }
+      OS << "};\n";
+    }
+    OS << "\nconst sfmt::PrecompiledFormat formats[] {\n";
+    for (std::size_t Ix = 0; Ix < Formats.size(); ++Ix) {
+      const Parsed& P = Formats[Ix];
+      OS << "  {";
+      writeLiteral(OS, P.Str);
+      OS << ", " << P.Str.size() << ", " << P.Specs.size()
+         << ", 0x" << std::hex << P.Hash << std::dec
+         << "ULL, specs" << Ix << "},\n";
+    }
+    OS << "};\n\n";
+    OS << "sfmt::PrecompiledBlock block {formats, "
+       << Formats.size() << "};\n";
+    OS << "} // namespace `anonymous`\n";
+  }
+} // namespace `anonymous`
+
+int main(int Argc, char** Argv) {
+  if (Argc < 2) {
+    std::fputs("usage: slimfmt-extract <output.cpp> <sources...>\n", stderr);
+    return 1;
+  }
+  sfmt::setErrorHandler(&recordError);
+
+  std::map<std::string, unsigned> Strings;
+  std::vector<Parsed> Formats;
+  for (int Ix = 2; Ix < Argc; ++Ix) {
+    const std::string Path = Argv[Ix];
+    std::ifstream File {Path, std::ios::binary};
+    if (!File) {
+      std::fprintf(stderr, "slimfmt-extract: cannot read %s\n", Path.c_str());
+      return 1;
+    }
+    std::stringstream SS;
+    SS << File.rdbuf();
+    const std::string Text = SS.str();
+    Source Src {Text};
+    std::map<std::string, unsigned> Found;
+    scanSource(Src, Found);
+    for (auto& [Str, Line] : Found) {
+      if (Strings.count(Str))
+        continue;
+      Parsed P;
+      if (!parseFormat(Str, P)) {
+        // Left to the runtime parser, which reports the error.
+        std::fprintf(stderr, "%s:%u: warning: skipping invalid format string\n",
+          Path.c_str(), Line);
+        continue;
+      }
+      Strings.emplace(Str, Line);
+      Formats.push_back(std::move(P));
+    }
+  }
+
+  std::ostringstream OS;
+  // An empty table would be zero sized.
+  if (Formats.empty())
+    OS << "// Generated by slimfmt-extract. No format strings found.\n";
+  else
+    writeTables(OS, Formats);
+  std::ofstream Out {Argv[1], std::ios::binary};
+  Out << OS.str();
+  if (!Out) {
+    std::fprintf(stderr, "slimfmt-extract: cannot write %s\n", Argv[1]);
+    return 1;
+  }
+  return 0;
+}